@@ -16,6 +16,610 @@
 
 #ifdef ESP32
 uint8_t WiFiManager::_lastconxresulttmp = WL_IDLE_STATUS;
+uint8_t WiFiManager::_lastdisconnectreason = 0;
+#define WM_REASON_NO_AP_FOUND WIFI_REASON_NO_AP_FOUND
+#else
+#define WM_REASON_NO_AP_FOUND WIFI_DISCONNECT_REASON_NO_AP_FOUND
+#endif
+
+#ifdef WM_CONNSTATS_RTC
+// connect stats rtc image, magic and checksum detect cold boots and layout changes
+#define WM_CONNSTATS_MAGIC 0x53434D57 // "WMCS"
+typedef struct {
+  uint32_t magic;
+  WiFiManager::wm_connstats_t stats;
+  uint32_t check;
+} __attribute__((aligned(4))) wm_connstats_rtc_t;
+
+#ifdef ESP32
+static RTC_NOINIT_ATTR wm_connstats_rtc_t wm_connstats_rtc;
+#endif
+
+// fnv-1a
+static uint32_t wm_connstats_check(const WiFiManager::wm_connstats_t &stats){
+  const uint8_t *p = (const uint8_t*)&stats;
+  uint32_t hash = 2166136261UL;
+  for(size_t i = 0; i < sizeof(stats); i++){
+    hash ^= p[i];
+    hash *= 16777619UL;
+  }
+  return hash;
+}
+#endif
+
+static void wm_connstats_inc(uint16_t &count){
+  if(count < 0xFFFF) count++;
+}
+
+/**
+ * --------------------------------------------------------------------------------
+ *  WiFiManagerEventRing
+ * --------------------------------------------------------------------------------
+**/
+
+bool WiFiManagerEventRing::push(uint8_t evt){
+  uint8_t head = _head.load(std::memory_order_relaxed);
+  uint8_t next = (head + 1) & (WM_EVENTRING_SIZE - 1);
+  if(next == _tail.load(std::memory_order_acquire)){
+    uint16_t dropped = _dropped.load(std::memory_order_relaxed);
+    if(dropped < 0xFFFF) _dropped.store(dropped + 1,std::memory_order_relaxed);
+    return false;
+  }
+  _buf[head] = evt;
+  _head.store(next,std::memory_order_release);
+  return true;
+}
+
+bool WiFiManagerEventRing::pop(uint8_t &evt){
+  uint8_t tail = _tail.load(std::memory_order_relaxed);
+  if(tail == _head.load(std::memory_order_acquire)) return false;
+  evt = _buf[tail];
+  _tail.store((tail + 1) & (WM_EVENTRING_SIZE - 1),std::memory_order_release);
+  return true;
+}
+
+uint16_t WiFiManagerEventRing::dropped(){
+  return _dropped.load(std::memory_order_relaxed);
+}
+
+/**
+ * --------------------------------------------------------------------------------
+ *  WiFiManagerDeflate
+ * --------------------------------------------------------------------------------
+**/
+
+// rfc1951 length and distance code bases and extra bits
+static const uint16_t wm_deflate_lbase[29] PROGMEM = {3,4,5,6,7,8,9,10,11,13,15,17,19,23,27,31,35,43,51,59,67,83,99,115,131,163,195,227,258};
+static const uint8_t  wm_deflate_lext[29]  PROGMEM = {0,0,0,0,0,0,0,0,1,1,1,1,2,2,2,2,3,3,3,3,4,4,4,4,5,5,5,5,0};
+static const uint16_t wm_deflate_dbase[30] PROGMEM = {1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,257,385,513,769,1025,1537,2049,3073,4097,6145,8193,12289,16385,24577};
+static const uint8_t  wm_deflate_dext[30]  PROGMEM = {0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
+// crc32 nibble table, small enough to keep
+static const uint32_t wm_crc32_nibble[16]  PROGMEM = {
+  0x00000000,0x1DB71064,0x3B6E20C8,0x26D930AC,0x76DC4190,0x6B6B51F4,0x4DB26158,0x5005713C,
+  0xEDB88320,0xF00F9344,0xD6D6A3E8,0xCB61B38C,0x9B64C2B0,0x86D3D2D4,0xA00AE278,0xBDBDF21C
+};
+
+WiFiManagerDeflate::WiFiManagerDeflate(std::function<void(const uint8_t*,size_t)> sink) : _sink(sink) {
+  // gzip member header, deflate, no flags, no mtime, unknown os
+  static const uint8_t gzhead[10] = {0x1f,0x8b,0x08,0x00,0x00,0x00,0x00,0x00,0x00,0xff};
+  for(uint8_t i = 0; i < sizeof(gzhead); i++) putByte(gzhead[i]);
+  putBits(1,1); // BFINAL, whole response is one block
+  putBits(1,2); // BTYPE fixed huffman
+}
+
+void WiFiManagerDeflate::write(const uint8_t *data, size_t len){
+  feed(data,len,false);
+}
+
+void WiFiManagerDeflate::write_P(PGM_P data, size_t len){
+  feed((const uint8_t*)data,len,true);
+}
+
+// copy input into the window, flash is read straight into it, compress as lookahead fills
+void WiFiManagerDeflate::feed(const uint8_t *data, size_t len, bool progmem){
+  while(len > 0){
+    if(_fill == BUFSIZE) slide();
+    uint16_t n = (size_t)(BUFSIZE - _fill) < len ? (BUFSIZE - _fill) : len;
+    if(progmem) memcpy_P(_buf + _fill, data, n);
+    else memcpy(_buf + _fill, data, n);
+    for(uint16_t i = 0; i < n; i++){
+      uint8_t b = _buf[_fill + i];
+      _crc = pgm_read_dword(&wm_crc32_nibble[(_crc ^ b) & 0x0F]) ^ (_crc >> 4);
+      _crc = pgm_read_dword(&wm_crc32_nibble[(_crc ^ (b >> 4)) & 0x0F]) ^ (_crc >> 4);
+    }
+    _fill += n;
+    _in   += n;
+    data  += n;
+    len   -= n;
+    compress(false);
+  }
+}
+
+// drop history older than the window, lookahead stays
+void WiFiManagerDeflate::slide(){
+  uint16_t shift = _pos - WINDOW;
+  memmove(_buf, _buf + shift, _fill - shift);
+  _pos  -= shift;
+  _fill -= shift;
+  for(uint16_t i = 0; i < HASHSIZE; i++) _head[i] = _head[i] > shift ? _head[i] - shift : 0;
+}
+
+uint16_t WiFiManagerDeflate::hash(uint16_t pos){
+  return ((_buf[pos] << 7) ^ (_buf[pos+1] << 4) ^ _buf[pos+2]) & (HASHSIZE - 1);
+}
+
+// greedy lz77, one hash candidate per position, keeps a full lookahead unless flushing
+void WiFiManagerDeflate::compress(bool flush){
+  while(_pos < _fill && (flush || _fill - _pos >= MAXMATCH)){
+    uint16_t avail = _fill - _pos;
+    uint16_t best  = 0;
+    uint16_t dist  = 0;
+    if(avail >= 3){
+      uint16_t h    = hash(_pos);
+      uint16_t cand = _head[h];
+      _head[h] = _pos + 1;
+      if(cand && _pos - (cand - 1) <= WINDOW){
+        cand--;
+        uint16_t max = avail < MAXMATCH ? avail : MAXMATCH;
+        uint16_t n   = 0;
+        while(n < max && _buf[cand + n] == _buf[_pos + n]) n++;
+        if(n >= 3){
+          best = n;
+          dist = _pos - cand;
+        }
+      }
+    }
+
+    if(best){
+      putMatch(best,dist);
+      for(uint16_t i = 1; i < best && _pos + i + 2 < _fill; i++) _head[hash(_pos + i)] = _pos + i + 1; // index skipped bytes
+      _pos += best;
+    }
+    else {
+      uint8_t lit = _buf[_pos++];
+      if(lit < 144) putHuff(0x30 + lit,8);
+      else putHuff(0x190 + lit - 144,9);
+    }
+  }
+}
+
+void WiFiManagerDeflate::putBits(uint32_t value, uint8_t bits){
+  _bitbuf |= value << _bitcnt;
+  _bitcnt += bits;
+  while(_bitcnt >= 8){
+    putByte(_bitbuf & 0xFF);
+    _bitbuf >>= 8;
+    _bitcnt -= 8;
+  }
+}
+
+// huffman codes are packed msb first
+void WiFiManagerDeflate::putHuff(uint16_t code, uint8_t bits){
+  uint16_t rev = 0;
+  for(uint8_t i = 0; i < bits; i++){
+    rev = (rev << 1) | (code & 1);
+    code >>= 1;
+  }
+  putBits(rev,bits);
+}
+
+void WiFiManagerDeflate::putLength(uint16_t sym){
+  if(sym < 280) putHuff(sym - 256,7);
+  else putHuff(0xC0 + sym - 280,8);
+}
+
+void WiFiManagerDeflate::putMatch(uint16_t len, uint16_t dist){
+  uint8_t i = 28;
+  while(pgm_read_word(&wm_deflate_lbase[i]) > len) i--;
+  putLength(257 + i);
+  putBits(len - pgm_read_word(&wm_deflate_lbase[i]),pgm_read_byte(&wm_deflate_lext[i]));
+  uint8_t j = 29;
+  while(pgm_read_word(&wm_deflate_dbase[j]) > dist) j--;
+  putHuff(j,5);
+  putBits(dist - pgm_read_word(&wm_deflate_dbase[j]),pgm_read_byte(&wm_deflate_dext[j]));
+}
+
+void WiFiManagerDeflate::putByte(uint8_t b){
+  _outbuf[_outlen++] = b;
+  _out++;
+  if(_outlen == sizeof(_outbuf)) flushOut();
+}
+
+void WiFiManagerDeflate::flushOut(){
+  if(_outlen == 0) return;
+  _sink(_outbuf,_outlen);
+  _outlen = 0;
+}
+
+// encode the rest, end of block, gzip trailer crc32 and size
+void WiFiManagerDeflate::finish(){
+  compress(true);
+  putLength(256);
+  if(_bitcnt) putBits(0,8 - _bitcnt);
+  uint32_t crc = ~_crc;
+  for(uint8_t i = 0; i < 4; i++) putByte((crc >> (i * 8)) & 0xFF);
+  for(uint8_t i = 0; i < 4; i++) putByte((_in >> (i * 8)) & 0xFF);
+  flushOut();
+}
+
+#ifdef WM_ASYNCWEBSERVER
+/**
+ * --------------------------------------------------------------------------------
+ *  WiFiManagerHTTPAsync
+ * --------------------------------------------------------------------------------
+**/
+
+/**
+ * response of a handled request, handed to the request with the first piece of the page
+ * the body is pulled from the per request piece queue as the client acks, the head goes out with the first piece
+ * called from the async context, and from process() on hand over and when a new piece is queued, both under the backend lock
+ */
+class WM_AsyncResponse : public AsyncAbstractResponse {
+  public:
+    WM_AsyncResponse(std::shared_ptr<WiFiManagerHTTPAsync::shared_t> ctl, std::shared_ptr<WiFiManagerHTTPAsync::out_t> out, int code, const String &type, size_t length, uint8_t version) : _ctl(ctl), _out(out) {
+      _code              = code;
+      _contentType       = type;
+      _contentLength     = length;
+      _sendContentLength = length > 0;
+      _chunked           = !_sendContentLength && version; // http/1.0 reads until close
+    }
+
+    bool _sourceValid() const override { return true; }
+
+    void _respond(AsyncWebServerRequest *request) override {
+      WiFiManagerHTTPAsync::lock(*_ctl);
+      if(_out->raw){
+        _state = RESPONSE_CONTENT;
+        ackRaw(request, 0);
+      }
+      else AsyncAbstractResponse::_respond(request); // head and the first piece, through _ack
+      WiFiManagerHTTPAsync::unlock(*_ctl);
+    }
+
+    size_t _ack(AsyncWebServerRequest *request, size_t len, uint32_t time) override {
+      WiFiManagerHTTPAsync::lock(*_ctl);
+      size_t ret = _out->raw ? ackRaw(request, len) : AsyncAbstractResponse::_ack(request, len, time);
+      WiFiManagerHTTPAsync::unlock(*_ctl);
+      return ret;
+    }
+
+    size_t _fillBuffer(uint8_t *data, size_t maxLen) override {
+      size_t n = 0;
+      while(n < maxLen && !_out->pieces.empty()){
+        size_t len = next(maxLen - n);
+        memcpy(data + n, _out->pieces.front().c_str() + _out->offset, len);
+        consume(len);
+        n += len;
+      }
+      if(!n) return _out->ended ? 0 : RESPONSE_TRY_AGAIN; // handler still running, the next piece kicks us
+      return n;
+    }
+
+  private:
+    // bytes of the front piece, up to max
+    size_t next(size_t max){
+      size_t len = _out->pieces.front().length() - _out->offset;
+      return len < max ? len : max;
+    }
+
+    void consume(size_t len){
+      _out->offset += len;
+      if(_out->offset < _out->pieces.front().length()) return;
+      _out->pieces.pop_front();
+      _out->offset = 0;
+    }
+
+    // prebuilt response, written as is, the connection is closed from the async context once it is acked
+    size_t ackRaw(AsyncWebServerRequest *request, size_t len){
+      AsyncClient *client = request->client();
+      _ackedLength += len;
+      size_t sent = 0;
+      if(_state == RESPONSE_CONTENT){
+        while(!_out->pieces.empty() && client->space()){
+          size_t n = client->write(_out->pieces.front().c_str() + _out->offset, next(client->space()));
+          if(!n) break;
+          consume(n);
+          sent += n;
+        }
+        _writtenLength += sent;
+        if(_out->ended && _out->pieces.empty()) _state = RESPONSE_WAIT_ACK;
+      }
+      if(_state == RESPONSE_WAIT_ACK && _ackedLength >= _writtenLength){ // acks may all be in before the end is queued
+        _state = RESPONSE_END;
+        client->close(true);
+      }
+      return sent;
+    }
+
+    std::shared_ptr<WiFiManagerHTTPAsync::shared_t> _ctl;
+    std::shared_ptr<WiFiManagerHTTPAsync::out_t>    _out;
+};
+
+WiFiManagerHTTPAsync::WiFiManagerHTTPAsync(AsyncWebServer &server, std::function<void()> dispatch) : _server(server), _dispatch(dispatch) {
+  _ctl = std::make_shared<shared_t>();
+  _ctl->owner = this;
+  #ifdef ESP32
+  _ctl->lock = xSemaphoreCreateRecursiveMutex();
+  #endif
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++){
+    _slots[i].req    = NULL;
+    _slots[i].queued = false;
+    _slots[i].busy   = false;
+    _slots[i].resp   = NULL;
+  }
+}
+
+WiFiManagerHTTPAsync::~WiFiManagerHTTPAsync(){
+  lock(*_ctl);
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++){
+    if(_slots[i].req && !_slots[i].resp) _slots[i].req->send(503); // still queued
+  }
+  _ctl->owner = NULL; // callbacks the server still holds find no owner
+  unlock(*_ctl);
+}
+
+// esp8266 async callbacks run in the sys context, which never preempts loop, nothing to lock
+void WiFiManagerHTTPAsync::lock(shared_t &ctl){
+  #ifdef ESP32
+  xSemaphoreTakeRecursive(ctl.lock, portMAX_DELAY);
+  #endif
+}
+
+void WiFiManagerHTTPAsync::unlock(shared_t &ctl){
+  #ifdef ESP32
+  xSemaphoreGiveRecursive(ctl.lock);
+  #endif
+}
+
+void WiFiManagerHTTPAsync::begin(){
+  std::shared_ptr<shared_t> ctl = _ctl;
+  _server.onNotFound([ctl](AsyncWebServerRequest *request){ accept(ctl, request); });
+}
+
+void WiFiManagerHTTPAsync::onUpload(const char *uri, ArUploadHandlerFunction upload){
+  std::shared_ptr<shared_t> ctl = _ctl;
+  _server.on(uri, HTTP_POST, [ctl](AsyncWebServerRequest *request){ accept(ctl, request); }, upload);
+}
+
+// async context, queue the request, or 503 once the backend is gone
+void WiFiManagerHTTPAsync::accept(std::shared_ptr<shared_t> ctl, AsyncWebServerRequest *request){
+  lock(*ctl);
+  if(ctl->owner) ctl->owner->onRequest(request);
+  else request->send(503);
+  unlock(*ctl);
+}
+
+/**
+ * async context, copy the request into a free slot for handle()
+ * the copy means handlers never touch a request the async stack may free
+ */
+void WiFiManagerHTTPAsync::onRequest(AsyncWebServerRequest *request){
+  slot_t *slot = NULL;
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++){
+    if(!_slots[i].req && !_slots[i].queued && !_slots[i].busy){
+      slot = &_slots[i];
+      break;
+    }
+  }
+  if(!slot){
+    request->send(503);
+    return;
+  }
+
+  slot->req       = request;
+  slot->queued    = true;
+  slot->seq       = _seq++;
+  slot->method    = request->method();
+  slot->localip   = request->client()->localIP();
+  slot->uri       = request->url();
+  slot->host      = request->host();
+  AsyncWebHeader *enc = request->getHeader(FPSTR(HTTP_HEAD_ACCEPTENC));
+  slot->acceptenc = enc ? enc->value() : String();
+  slot->names.clear();
+  slot->values.clear();
+  size_t args = request->args();
+  slot->names.reserve(args);
+  slot->values.reserve(args);
+  for(size_t i = 0; i < args; i++){
+    slot->names.push_back(request->argName(i));
+    slot->values.push_back(request->arg(i));
+  }
+
+  slot->resp      = NULL;
+  slot->out.reset();
+
+  // the request is freed after this returns, holding the lock keeps it alive while process() writes to it
+  std::shared_ptr<shared_t> ctl = _ctl;
+  request->onDisconnect([ctl, request](){
+    lock(*ctl);
+    if(ctl->owner) ctl->owner->forget(request);
+    unlock(*ctl);
+  });
+}
+
+// async context, the request is about to be freed
+void WiFiManagerHTTPAsync::forget(AsyncWebServerRequest *request){
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++){
+    if(_slots[i].req == request){
+      _slots[i].req    = NULL;
+      _slots[i].queued = false;
+      _slots[i].resp   = NULL; // freed with the request
+    }
+  }
+}
+
+/**
+ * serve the oldest queued request, runs the portal handlers from process()
+ * @return false if nothing was queued
+ */
+bool WiFiManagerHTTPAsync::handle(){
+  lock(*_ctl);
+  int8_t next = -1;
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++){
+    if(_slots[i].queued && (next < 0 || (int32_t)(_slots[i].seq - _slots[next].seq) < 0)) next = i;
+  }
+  if(next >= 0){
+    _slots[next].queued = false;
+    _slots[next].busy   = true;
+    _slots[next].out    = std::make_shared<out_t>();
+  }
+  unlock(*_ctl);
+  if(next < 0) return false;
+
+  _cur     = next;
+  _started = false;
+  _done    = false;
+  _dispatch();
+  if(!_started) send(500, FPSTR(HTTP_HEAD_CT2), ""); // handler sent nothing
+  else respond(); // handler left a chunked response open
+
+  lock(*_ctl);
+  _slots[_cur].busy = false;
+  unlock(*_ctl);
+  _cur = -1;
+  _headers.clear();
+  return true;
+}
+
+uint8_t WiFiManagerHTTPAsync::pending(){
+  uint8_t n = 0;
+  lock(*_ctl);
+  for(uint8_t i = 0; i < WM_ASYNC_QUEUE; i++) if(_slots[i].queued) n++;
+  unlock(*_ctl);
+  return n;
+}
+
+// set code and headers, they go out with the first piece, see flush
+void WiFiManagerHTTPAsync::start(int code, const String &type, size_t length, bool raw){
+  if(_started || _cur < 0) return;
+  _started = true;
+  _code    = code;
+  _type    = type;
+  _length  = length;
+  _slots[_cur].out->raw = raw; // not shared before the hand over
+}
+
+/**
+ * queue a piece of the response for the async stack, the caller coalesces pages into WM_SENDBUF_SIZE pieces
+ * pieces stay queued until the client acks them, a page is held in full at worst, dropped if the client went away
+ */
+void WiFiManagerHTTPAsync::write(const char *data, size_t len, bool progmem){
+  if(!_started || _done || _cur < 0 || len == 0) return;
+  String piece;
+  if(!piece.reserve(len)) return;
+  if(progmem) for(size_t i = 0; i < len; i++) piece += (char)pgm_read_byte(data + i);
+  else piece.concat(data, len);
+
+  lock(*_ctl);
+  if(_slots[_cur].req){ // else the client went away
+    _slots[_cur].out->pieces.push_back(std::move(piece));
+    flush();
+  }
+  unlock(*_ctl);
+}
+
+void WiFiManagerHTTPAsync::respond(){
+  if(_done || !_started || _cur < 0) return;
+  _done = true;
+  lock(*_ctl);
+  _slots[_cur].out->ended = true;
+  if(_slots[_cur].req) flush();
+  unlock(*_ctl);
+}
+
+/**
+ * first piece, hand the response to the request, its _respond writes the head and the piece now
+ * later pieces, have an idle response pull them, one that is waiting on acks pulls them when they come
+ * safe from process(): the disconnect handler takes the same lock, so req cannot be freed while it is held,
+ * and the esp32 async tcp routes writes through the tcpip thread
+ */
+void WiFiManagerHTTPAsync::flush(){
+  slot_t &slot = _slots[_cur];
+  if(!slot.resp){
+    slot.resp = new WM_AsyncResponse(_ctl, slot.out, _code, _type, _length, slot.req->version());
+    for(auto &h : _headers) slot.resp->addHeader(h.first, h.second);
+    _headers.clear();
+    slot.req->send(slot.resp);
+  }
+  else if(slot.req->client()->canSend()) slot.resp->_ack(slot.req, 0, 0);
+}
+
+const String& WiFiManagerHTTPAsync::uri(){
+  return _cur < 0 ? _empty : _slots[_cur].uri;
+}
+
+WM_HTTPMethod WiFiManagerHTTPAsync::method(){
+  return _cur < 0 ? (WM_HTTPMethod)HTTP_GET : _slots[_cur].method;
+}
+
+int WiFiManagerHTTPAsync::args(){
+  return _cur < 0 ? 0 : _slots[_cur].names.size();
+}
+
+const String& WiFiManagerHTTPAsync::arg(int i){
+  return (_cur < 0 || i < 0 || i >= args()) ? _empty : _slots[_cur].values[i];
+}
+
+const String& WiFiManagerHTTPAsync::argName(int i){
+  return (_cur < 0 || i < 0 || i >= args()) ? _empty : _slots[_cur].names[i];
+}
+
+bool WiFiManagerHTTPAsync::hasArg(const String &name){
+  for(int i = 0; i < args(); i++) if(_slots[_cur].names[i] == name) return true;
+  return false;
+}
+
+const String& WiFiManagerHTTPAsync::hostHeader(){
+  return _cur < 0 ? _empty : _slots[_cur].host;
+}
+
+// only Accept-Encoding is kept from the request headers
+const String& WiFiManagerHTTPAsync::header(const String &name){
+  if(_cur < 0 || !name.equalsIgnoreCase(FPSTR(HTTP_HEAD_ACCEPTENC))) return _empty;
+  return _slots[_cur].acceptenc;
+}
+
+IPAddress WiFiManagerHTTPAsync::localIP(){
+  return _cur < 0 ? IPAddress() : _slots[_cur].localip;
+}
+
+void WiFiManagerHTTPAsync::sendHeader(const String &name, const String &value){
+  if(!_started) _headers.push_back(std::make_pair(name, value));
+}
+
+void WiFiManagerHTTPAsync::send(int code, const String &type, const String &content){
+  start(code, type, content.length());
+  write(content.c_str(), content.length());
+  respond();
+}
+
+void WiFiManagerHTTPAsync::sendChunked(int code, const String &type){
+  start(code, type);
+}
+
+void WiFiManagerHTTPAsync::sendContent(const char *data, size_t len){
+  write(data, len);
+}
+
+void WiFiManagerHTTPAsync::sendContent_P(PGM_P data){
+  write(data, strlen_P(data), true);
+}
+
+void WiFiManagerHTTPAsync::sendChunkedEnd(){
+  respond();
+}
+
+void WiFiManagerHTTPAsync::sendRaw(const uint8_t *data, size_t len){
+  start(0, String(), 0, true);
+  write((const char*)data, len);
+  respond();
+}
+
+void WiFiManagerHTTPAsync::sendRaw_P(PGM_P data, size_t len){
+  start(0, String(), 0, true);
+  write(data, len, true);
+  respond();
+}
 #endif
 
 /**
@@ -223,7 +827,13 @@ void WiFiManager::WiFiManagerInit(){
 
 // destructor
 WiFiManager::~WiFiManager() {
+  #ifdef ESP32
+  portalTaskJoin(); // task stops the portal and exits before anything is freed
+  #endif
   _end();
+  #ifndef WM_ASYNCWEBSERVER
+  unmountWebPortal(); // the app server may outlive us, a server deleted first has already unmounted it
+  #endif
   // parameters
   // @todo below belongs to wifimanagerparameter
   if (_params != NULL){
@@ -238,6 +848,11 @@ WiFiManager::~WiFiManager() {
   // WiFi.onEvent(std::bind(&WiFiManager::WiFiEvent,this,_1,_2));
   #ifdef ESP32
     WiFi.removeEvent(wm_event_id);
+    if(!_portalTask){ // still running only if destroyed from inside the task
+      if(_taskCmdQueue) vQueueDelete(_taskCmdQueue);
+      if(_taskEvtQueue) vQueueDelete(_taskEvtQueue);
+      if(_portalMutex) vSemaphoreDelete(_portalMutex);
+    }
   #endif
 
   #ifdef WM_DEBUG_LEVEL
@@ -255,6 +870,32 @@ void WiFiManager::_begin(){
   #endif
 }
 
+unsigned long WiFiManager::_millis(){
+  return _millisfunc ? _millisfunc() + _clockWaited : millis();
+}
+
+void WiFiManager::_delay(unsigned long ms){
+  if(_delayfunc){
+    _delayfunc(ms);
+    yield(); // still feed the watchdog
+  }
+  else if(_millisfunc){
+    _clockWaited += ms; // nothing advances the virtual clock for us, waits would never time out
+    yield();
+  }
+  else delay(ms);
+}
+
+uint8_t WiFiManager::WiFi_status(){
+  return _statusfunc ? _statusfunc() : (uint8_t)WiFi.status();
+}
+
+bool WiFiManager::WiFi_begin(const char *ssid, const char *pass, bool connect){
+  if(_beginfunc) return _beginfunc(ssid,pass);
+  if(ssid) return WiFi.begin(ssid, pass, 0, NULL, connect);
+  return WiFi.begin(); // stored config
+}
+
 void WiFiManager::_end(){
   _hasBegun = false;
   if(_userpersistent) WiFi.persistent(true); // reenable persistent, there is no getter we rely on _userpersistent
@@ -280,7 +921,23 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
   DEBUG_WM(F("AutoConnect"));
   #endif
 
-  _WifiAP_active = false;
+  _WifiAP_active       = false;
+  timerArm(WM_TIMER_AUTOCONNECT,0);
+  _autoConnectDuration = 0;
+  _autoConnectFast     = false;
+
+  // warm boot, sdk already reconnected from stored config, skip mode changes and begin
+  if(_fastAutoConnect && autoConnectFast()){
+    _autoConnectDuration = timerElapsed(WM_TIMER_AUTOCONNECT);
+    _autoConnectFast     = true;
+    _lastconxresult      = WL_CONNECTED;
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(F("AutoConnect: SUCCESS (already connected)"));
+    DEBUG_WM(DEBUG_VERBOSE,F("Connected in"),(String)_autoConnectDuration + " ms");
+    DEBUG_WM(F("STA IP Address:"),WiFi.localIP());
+    #endif
+    return true;
+  }
 
   // bool wifiIsSaved = getWiFiIsSaved();
 
@@ -291,11 +948,12 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
     // disable wifi if already on
     if(WiFi.getMode() & WIFI_STA){
       WiFi.mode(WIFI_OFF);
-      int timeout = millis()+1200;
+      timerArm(WM_TIMER_WAIT,1200);
       // async loop for mode change
-      while(WiFi.getMode()!= WIFI_OFF && millis()<timeout){
-        delay(0);
+      while(WiFi.getMode()!= WIFI_OFF && !timerExpired(WM_TIMER_WAIT)){
+        _delay(0);
       }
+      timerStop(WM_TIMER_WAIT);
     }
   }
   #endif
@@ -303,7 +961,6 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
   // check if wifi is saved, (has autoconnect) to speed up cp start
   // NOT wifi init safe
   // if(wifiIsSaved){
-     _startconn = millis();
     _begin();
 
     // attempt to connect using saved settings, on fail fallback to AP config portal
@@ -338,7 +995,7 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
     // @note @todo ESP32 has no autoconnect, so connectwifi will always be called unless user called begin etc before
     // @todo check if correct ssid == saved ssid when already connected
     bool connected = false;
-    if (WiFi.status() == WL_CONNECTED){
+    if (WiFi_status() == WL_CONNECTED){
       connected = true;
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(F("AutoConnect: ESP Already Connected"));
@@ -350,12 +1007,12 @@ boolean WiFiManager::autoConnect(char const *apName, char const *apPassword) {
 
     if(connected || connectWifi(_defaultssid, _defaultpass) == WL_CONNECTED){
       //connected
+      _autoConnectDuration = timerElapsed(WM_TIMER_AUTOCONNECT);
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(F("AutoConnect: SUCCESS"));
-      DEBUG_WM(DEBUG_VERBOSE,F("Connected in"),(String)((millis()-_startconn)) + " ms");
+      DEBUG_WM(DEBUG_VERBOSE,F("Connected in"),(String)_autoConnectDuration + " ms");
       DEBUG_WM(F("STA IP Address:"),WiFi.localIP());
       #endif
-      // Serial.println("Connected in " + (String)((millis()-_startconn)) + " ms");
       _lastconxresult = WL_CONNECTED;
 
       if(_hostname != ""){
@@ -465,6 +1122,7 @@ bool WiFiManager::setupHostname(bool restart){
 bool WiFiManager::startAP(){
   _WifiAP_active = true;
   bool ret = true;
+  unsigned long apstart = _millis();
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(F("StartAP with SSID: "),_apName);
   #endif
@@ -477,7 +1135,10 @@ bool WiFiManager::startAP(){
       #endif
       return false;
     }
-    delay(500); // workaround delay
+    WiFi_waitAPReady(500); // workaround, ap interface must be up before softAPConfig
+  #elif defined(ESP32)
+    WiFi_initEvents();
+    _apstarted = (WiFi.getMode() & WIFI_AP); // already up, no AP_START will follow
   #endif
 
   // setup optional soft AP static ip config
@@ -530,10 +1191,12 @@ bool WiFiManager::startAP(){
 
   // @todo add softAP retry here to dela with unknown failures
   
-  delay(500); // slight delay to make sure we get an AP IP
+  if(ret) WiFi_waitAPReady(1000); // make sure we get an AP IP
+  _apStartDuration = _millis() - apstart;
   #ifdef WM_DEBUG_LEVEL
   if(!ret) DEBUG_WM(DEBUG_ERROR,F("[ERROR] There was a problem starting the AP"));
   DEBUG_WM(F("AP IP address:"),WiFi.softAPIP());
+  DEBUG_WM(DEBUG_VERBOSE,F("AP started in"),(String)_apStartDuration + " ms");
   #endif
 
   // set ap hostname
@@ -557,18 +1220,129 @@ bool WiFiManager::startAP(){
  * @return {[type]} [description]
  */
 void WiFiManager::startWebPortal() {
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
   if(configPortalActive || webPortalActive) return;
   connect = abort = false;
+  _saveState = SAVE_IDLE;
+  timerStop(WM_TIMER_SAVE);
   setupConfigPortal();
   webPortalActive = true;
 }
 
+#ifndef WM_ASYNCWEBSERVER
+// cores without removeHandler keep the handler registered, it is disarmed instead
+template<typename S, typename H>
+static auto wm_removeHandler(S &server, H *handler, int) -> decltype(server.removeHandler(handler), bool()) {
+  server.removeHandler(handler);
+  return true;
+}
+template<typename S, typename H>
+static bool wm_removeHandler(S &, H *, long) {
+  return false;
+}
+
+/**
+ * serve the web portal from an existing app webserver, pages live under prefix
+ * no second listener, socket or page buffers, the app keeps calling its server handleClient and process() for saves
+ * routes the app registered before match first, there is no captive redirect on a mounted portal
+ * @since $dev
+ * @access public
+ * @param server app webserver, deleting it first ends the web portal
+ * @param prefix eg "/wm", NULL or "" mounts the portal routes at root
+ */
+void WiFiManager::startWebPortal(WM_WebServer &server, const char *prefix) {
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
+  if(configPortalActive || webPortalActive) return;
+  connect = abort = false;
+  _saveState = SAVE_IDLE;
+  timerStop(WM_TIMER_SAVE);
+
+  _httpPrefix = prefix ? prefix : "";
+  while(_httpPrefix.endsWith("/")) _httpPrefix.remove(_httpPrefix.length() - 1);
+  _http.reset();
+  if(this->server){ // a server left from an earlier portal would hold its port and never be pumped
+    this->server->stop();
+    this->server.reset();
+  }
+  _appServer = &server;
+  _http.reset(new WM_HTTPSync(server));
+  _mountHandler.reset(new WM_MountHandler(this));
+  server.addHandler(_mountHandler.get());
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("Web Portal mounted at"),_httpPrefix.length() ? _httpPrefix : String('/'));
+  #endif
+
+  _lastscan = 0; // reset network scan cache
+  timerStop(WM_TIMER_SCANCACHE);
+  if(_preloadwifiscan) WiFi_scanNetworks(true,true); // preload wifiscan , async
+  webPortalActive = true;
+}
+
+/**
+ * remove the portal routes from the app server, the server itself keeps running
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::unmountWebPortal() {
+  if(!_mountHandler) return;
+  _mountHandler->_wm = NULL; // disarmed, even if the core cannot remove it
+  if(wm_removeHandler(*_appServer, _mountHandler.get(), 0)) _mountHandler.reset();
+  else _mountHandler.release(); // still referenced by the core, a few bytes are left behind
+  _appServer  = NULL;
+  _http.reset();
+  _httpPrefix = "";
+}
+
+/**
+ * an app server deletes its handlers when it goes first, the portal lets go of the server with it
+ * @since $dev
+ * @access private
+ */
+WiFiManager::WM_MountHandler::~WM_MountHandler() {
+  if(!_wm) return; // unmounted, the portal no longer owns or uses it
+  _wm->_mountHandler.release();
+  _wm->_appServer  = NULL;
+  _wm->_http.reset();
+  _wm->_httpPrefix = "";
+  _wm->webPortalActive = false;
+}
+
+/**
+ * mount handler match, the prefix itself, anything under a prefix, or the portal routes at root
+ * @since $dev
+ * @access private
+ */
+bool WiFiManager::mountMatch(const String &uri, bool upload) {
+  if(!uri.startsWith(_httpPrefix)) return false;
+  const char *path = uri.c_str() + _httpPrefix.length();
+  if(*path && *path != '/') return false; // /wmx is not under /wm
+  if(!*path) path = "/";
+  if(strcmp_P(path, R_updatedone) == 0) return true; // ota upload and done page
+  if(upload) return false;
+  if(_httpPrefix.length() > 0) return true; // unknown paths under the prefix get the portal 404
+  return findRoute(path, routeHash(path), strlen(path)) != NULL;
+}
+
+bool WiFiManager::mountHandle(HTTPMethod method, const String &uri) {
+  if(method == HTTP_POST && strcmp_P(routePath(uri), R_updatedone) == 0) handleUpdateDone();
+  else handleRoute();
+  return true;
+}
+#endif
+
 /**
  * [stopWebPortal description]
  * @access public
  * @return {[type]} [description]
  */
 void WiFiManager::stopWebPortal() {
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
   if(!configPortalActive && !webPortalActive) return;
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_VERBOSE,F("Stopping Web Portal"));  
@@ -578,7 +1352,9 @@ void WiFiManager::stopWebPortal() {
 }
 
 bool WiFiManager::WifiAP_active(int max_uptime_minutes){
-  if((millis()-_startconn) < (max_uptime_minutes * 60000)){
+  // since boot if autoConnect never ran
+  unsigned long uptime = _timers[WM_TIMER_AUTOCONNECT].armed ? timerElapsed(WM_TIMER_AUTOCONNECT) : _millis();
+  if(uptime < ((unsigned long)max_uptime_minutes * 60000UL)){
     return (_WifiAP_active);
   }
   return false;
@@ -591,21 +1367,32 @@ boolean WiFiManager::configPortalHasTimeout(){
     // handle timeout portal client check
     if(_configPortalTimeout == 0 || (_apClientCheck && (WiFi_softap_num_stations() > 0))){
       // debug num clients every 30s
-      if(millis() - timer > logintvl){
-        timer = millis();
+      if(timerEvery(WM_TIMER_LOG,logintvl)){
         #ifdef WM_DEBUG_LEVEL
         DEBUG_WM(DEBUG_VERBOSE,F("NUM CLIENTS: "),(String)WiFi_softap_num_stations());
         #endif
       }
-      _configPortalStart = millis(); // kludge, bump configportal start time to skew timeouts
+      if(_configPortalTimeout == 0) timerStop(WM_TIMER_PORTAL);
+      else timerArm(WM_TIMER_PORTAL,_configPortalTimeout); // kludge, restart configportal timeout
+      return false;
+    }
+
+    // save in progress, do not time out under a connecting client
+    if(_saveState != SAVE_IDLE){
+      timerArm(WM_TIMER_PORTAL,_configPortalTimeout);
       return false;
     }
 
-    // handle timeout webclient check
-    if(_webClientCheck && (_webPortalAccessed>_configPortalStart)>0) _configPortalStart = _webPortalAccessed;
+    // handle timeout webclient check, restart from last access, (long) cast keeps the compare rollover safe
+    unsigned long portalstart = _timers[WM_TIMER_PORTAL].start;
+    if(_webClientCheck && (long)(_webPortalAccessed - portalstart) > 0) portalstart = _webPortalAccessed;
+    // timeout may have been changed while running, also arms on first call
+    if(!_timers[WM_TIMER_PORTAL].armed || portalstart != _timers[WM_TIMER_PORTAL].start || _timers[WM_TIMER_PORTAL].interval != _configPortalTimeout){
+      timerArm(WM_TIMER_PORTAL,_configPortalTimeout,_timers[WM_TIMER_PORTAL].armed ? portalstart : _millis());
+    }
 
     // handle timed out
-    if(millis() > _configPortalStart + _configPortalTimeout){
+    if(timerExpired(WM_TIMER_PORTAL)){
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(F("config portal has timed out"));
       #endif
@@ -613,10 +1400,9 @@ boolean WiFiManager::configPortalHasTimeout(){
     } 
     else if(_debug && _debugLevel > 0) {
       // log timeout time remaining every 30s
-      if((millis() - timer) > logintvl){
-        timer = millis();
+      if(timerEvery(WM_TIMER_LOG,logintvl)){
         #ifdef WM_DEBUG_LEVEL
-        DEBUG_WM(DEBUG_VERBOSE,F("Portal Timeout In"),(String)((_configPortalStart + _configPortalTimeout-millis())/1000) + (String)F(" seconds"));
+        DEBUG_WM(DEBUG_VERBOSE,F("Portal Timeout In"),(String)(timerRemaining(WM_TIMER_PORTAL)/1000) + (String)F(" seconds"));
         #endif
       }
     }
@@ -636,9 +1422,44 @@ void WiFiManager::setupHTTPServer(){
     #endif
   }
 
-  server.reset(new WM_WebServer(_httpPort));
+  // kept server from a previous portal, still listening, routes and callback handlers are still registered
+  if(server && _http && _httpServerPort == _httpPort && !_httpServerStale){
+    if(_httpServerClosed) server->begin();
+    _httpServerClosed = false;
+    buildCaptiveRedirect(configPortalActive ? WiFi.softAPIP() : WiFi.localIP());
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("HTTP server resumed"));
+    #endif
+    return;
+  }
+  _http.reset(); // stale kept server, closed before the new one binds
+  server.reset();
+  _httpServerPort   = _httpPort;
+  _httpServerStale  = false;
+  _httpServerClosed = false;
+
+  #ifdef WM_ASYNCWEBSERVER
+  server.reset(new AsyncWebServer(_httpPort));
+  _http.reset(new WiFiManagerHTTPAsync(*server, std::bind(&WiFiManager::handleRoute, this)));
+  #else
+  server.reset(new WM_HTTPServer(_httpPort));
+  _http.reset(new WM_HTTPSync(*server));
+  #endif
+
+  // captive redirect is built once here, softap is already up for the config portal
+  buildCaptiveRedirect(configPortalActive ? WiFi.softAPIP() : WiFi.localIP());
+
   // This is not the safest way to reset the webserver, it can cause crashes on callbacks initilized before this and since its a shared pointer...
 
+  // before the callback, headers collected there replace these and disable gzip
+  // the async backend keeps all request headers
+  #ifndef WM_ASYNCWEBSERVER
+  if(_httpCompression){
+    const char *headerkeys[] = {"Accept-Encoding"}; // ram copy, core copies keys into Strings
+    server->collectHeaders(headerkeys,1);
+  }
+  #endif
+
   if ( _webservercallback != NULL) {
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM(DEBUG_VERBOSE,F("[CB] _webservercallback calling"));
@@ -649,23 +1470,24 @@ void WiFiManager::setupHTTPServer(){
   
   /* Setup httpd callbacks, web pages: root, wifi config pages, SO captive portal detectors and not found. */
 
-  // G macro workaround for Uri() bug https://github.com/esp8266/Arduino/issues/7102
-  server->on(WM_G(R_root),       std::bind(&WiFiManager::handleRoot, this));
-  server->on(WM_G(R_wifi),       std::bind(&WiFiManager::handleWifi, this, true));
-  server->on(WM_G(R_wifinoscan), std::bind(&WiFiManager::handleWifi, this, false));
-  server->on(WM_G(R_wifisave),   std::bind(&WiFiManager::handleWifiSave, this));
-  server->on(WM_G(R_info),       std::bind(&WiFiManager::handleInfo, this));
-  server->on(WM_G(R_param),      std::bind(&WiFiManager::handleParam, this));
-  server->on(WM_G(R_paramsave),  std::bind(&WiFiManager::handleParamSave, this));
-  server->on(WM_G(R_restart),    std::bind(&WiFiManager::handleReset, this));
-  server->on(WM_G(R_exit),       std::bind(&WiFiManager::handleExit, this));
-  server->on(WM_G(R_close),      std::bind(&WiFiManager::handleClose, this));
-  server->on(WM_G(R_erase),      std::bind(&WiFiManager::handleErase, this, false));
-  server->on(WM_G(R_status),     std::bind(&WiFiManager::handleWiFiStatus, this));
-  server->onNotFound (std::bind(&WiFiManager::handleNotFound, this));
+  // portal pages are dispatched from the notfound handler through _routes, see handleRoute
+  // routes registered in _webservercallback still match first
+  #ifdef WM_ASYNCWEBSERVER
+  static_cast<WiFiManagerHTTPAsync*>(_http.get())->begin(); // notfound queues the request for handleRoute
+
+  // ota upload, chunks arrive in the async context and go straight to Update, the done page is queued
+  static_cast<WiFiManagerHTTPAsync*>(_http.get())->onUpload(WM_G(R_updatedone), [this](AsyncWebServerRequest *request, const String &filename, size_t index, uint8_t *data, size_t len, bool final){
+    if(index == 0) handleUpload(WM_OTA_START, filename, NULL, 0, 0);
+    if(len > 0) handleUpload(WM_OTA_WRITE, filename, data, len, 0);
+    if(final) handleUpload(WM_OTA_END, filename, NULL, 0, index + len);
+  });
+  #else
+  server->onNotFound (std::bind(&WiFiManager::handleRoute, this));
   
-  server->on(WM_G(R_update), std::bind(&WiFiManager::handleUpdate, this));
+  // ota upload needs the core upload handler
+  // G macro workaround for Uri() bug https://github.com/esp8266/Arduino/issues/7102
   server->on(WM_G(R_updatedone), HTTP_POST, std::bind(&WiFiManager::handleUpdateDone, this), std::bind(&WiFiManager::handleUpdating, this));
+  #endif
   
   server->begin(); // Web server start
   #ifdef WM_DEBUG_LEVEL
@@ -688,6 +1510,7 @@ void WiFiManager::setupDNSD(){
 void WiFiManager::setupConfigPortal() {
   setupHTTPServer();
   _lastscan = 0; // reset network scan cache
+  timerStop(WM_TIMER_SCANCACHE);
   if(_preloadwifiscan) WiFi_scanNetworks(true,true); // preload wifiscan , async
 }
 
@@ -704,6 +1527,9 @@ boolean WiFiManager::startConfigPortal() {
  * @return {[type]}      [description]
  */
 boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPassword) {
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
   _begin();
 
   if(configPortalActive){
@@ -744,9 +1570,14 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
   // init configportal globals to known states
   configPortalActive = true;
   bool result = connect = abort = false; // loop flags, connect true success, abort true break
+  _saveState = SAVE_IDLE;
+  timerStop(WM_TIMER_SAVE);
   uint8_t state;
 
-  _configPortalStart = millis();
+  if(_configPortalTimeout > 0) timerArm(WM_TIMER_PORTAL,_configPortalTimeout);
+  else timerStop(WM_TIMER_PORTAL);
+  // no web access yet, a stale stamp would compare as newer than the portal start once millis is past half its range
+  _webPortalAccessed = _millis() - 2000;
 
   // start access point
   #ifdef WM_DEBUG_LEVEL
@@ -790,7 +1621,10 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
     if(_configPortalTimeout > 0) DEBUG_WM(DEBUG_VERBOSE,F("Portal Timeout In"),(String)(_configPortalTimeout/1000) + (String)F(" seconds"));
   #endif
 
+  _cpBusyTime = _cpIdleTime = 0;
+
   while(1){
+    unsigned long loopstart = micros();
 
     // if timed out or abort, break
     if(configPortalHasTimeout() || abort){
@@ -799,6 +1633,7 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
       #endif
       shutdownConfigPortal();
       result = abort ? portalAbortResult : portalTimeoutResult; // false, false
+      if(!abort) postPortalEvent(WM_EVT_TIMEOUT);
       if (_configportaltimeoutcallback != NULL) {
         #ifdef WM_DEBUG_LEVEL
         DEBUG_WM(DEBUG_VERBOSE,F("[CB] config portal timeout callback"));
@@ -821,7 +1656,24 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
 
     if(!configPortalActive) break;
 
-    yield(); // watchdog
+    unsigned long busy = micros() - loopstart;
+    if(_cpIdleSleep > 0 && configPortalIdle()){
+      // sleep instead of spinning, delay lets the sdk idle the cpu, bounds wake latency to _cpIdleSleep
+      // never sleep past a pending deadline, portal timeout etc.
+      unsigned long sleepms = getNextDeadline();
+      if(sleepms > _cpIdleSleep) sleepms = _cpIdleSleep;
+      unsigned long sleepstart = micros();
+      _delay(sleepms);
+      _cpIdleTime += micros() - sleepstart;
+    }
+    else yield(); // watchdog
+    _cpBusyTime += busy;
+
+    // duty cycle over ~10s windows
+    if(_cpBusyTime + _cpIdleTime >= 10000000UL){
+      _cpDutyCycle = (uint8_t)((_cpBusyTime / 1000) * 100 / ((_cpBusyTime + _cpIdleTime) / 1000));
+      _cpBusyTime = _cpIdleTime = 0;
+    }
   }
 
   #ifdef WM_DEBUG_LEVEL
@@ -836,11 +1688,14 @@ boolean  WiFiManager::startConfigPortal(char const *apName, char const *apPasswo
  * @return bool connected
  */
 boolean WiFiManager::process(){
-    // process mdns, esp32 not required
-    #if defined(WM_MDNS) && defined(ESP8266)
-    MDNS.update();
+    #ifdef ESP32
+    // portal task owns processing, calls from the app loop are a no-op
+    if(_portalTask && xTaskGetCurrentTaskHandle() != _portalTask) return false;
     #endif
-	
+
+    // mdns, esp32 not required, and reconnect scheduler, no-op unless setReconnectBackoff
+    uint8_t tasks = (1 << WM_TASK_MDNS) | (1 << WM_TASK_RECONNECT);
+
     if(webPortalActive || (configPortalActive && !_configPortalIsBlocking)){
       // if timed out or abort, break
       if(_allowExit && (configPortalHasTimeout() || abort)){
@@ -849,6 +1704,7 @@ boolean WiFiManager::process(){
         #endif
         webPortalActive = false;
         shutdownConfigPortal();
+        if(!abort) postPortalEvent(WM_EVT_TIMEOUT);
         if (_configportaltimeoutcallback != NULL) {
           #ifdef WM_DEBUG_LEVEL
           DEBUG_WM(DEBUG_VERBOSE,F("[CB] config portal timeout callback"));
@@ -857,11 +1713,12 @@ boolean WiFiManager::process(){
         }
         return false;
       }
-
-      uint8_t state = processConfigPortal(); // state is WL_IDLE or WL_CONNECTED/FAILED
-      return state == WL_CONNECTED;
+      tasks |= (1 << WM_TASK_DNS) | (1 << WM_TASK_HTTP) | (1 << WM_TASK_SAVE);
     }
-    return false;
+    else if(server && _httpPersistent && !_httpServerClosed) tasks |= (1 << WM_TASK_HTTP); // kept server, answer 503 while stopped
+
+    uint8_t state = runTasks(tasks); // state is WL_IDLE or WL_CONNECTED/FAILED
+    return state == WL_CONNECTED;
 }
 
 /**
@@ -872,90 +1729,488 @@ boolean WiFiManager::process(){
  * @return {[type]} [description]
  */
 uint8_t WiFiManager::processConfigPortal(){
-    if(configPortalActive){
-      //DNS handler
-      dnsServer->processNextRequest();
+    return runTasks((1 << WM_TASK_DNS) | (1 << WM_TASK_HTTP) | (1 << WM_TASK_SAVE));
+}
+
+/**
+ * cooperative scheduler, dns runs every pass, the rest round robin
+ * once a task has run and the process budget is spent, remaining tasks resume next call
+ * @since $dev
+ * @access private
+ * @param  uint8_t tasks bitmask of 1 << wm_task_t
+ * @return uint8_t WL_IDLE_STATUS, or save result, which ends the pass
+ */
+uint8_t WiFiManager::runTasks(uint8_t tasks){
+  unsigned long start  = micros();
+  unsigned long budget = _processBudget * 1000;
+  uint8_t state = WL_IDLE_STATUS;
+  uint8_t ran   = 0;
+
+  connTimingPoll(); // attempts closed by wifi events are recorded here, not in the event task
+  WiFi_scanPoll();
+
+  // dns first, cheap and the most latency sensitive
+  if(tasks & (1 << WM_TASK_DNS)) runTask(WM_TASK_DNS);
+
+  uint8_t first = _taskNext;
+  for(uint8_t n = 0; n < WM_TASK_MAX - 1; n++){
+    wm_task_t task = (wm_task_t)(1 + (first - 1 + n) % (WM_TASK_MAX - 1));
+    if(!(tasks & (1 << task))) continue;
+    if(ran && budget && (micros() - start >= budget)){
+      _taskNext = task; // out of budget, resume here
+      break;
+    }
+    state = runTask(task);
+    ran++;
+    if(state != WL_IDLE_STATUS){
+      _taskNext = 1 + (task % (WM_TASK_MAX - 1)); // portal may be shut down, end pass
+      break;
     }
+  }
 
-    //HTTP handler
-    server->handleClient();
+  unsigned long took = micros() - start;
+  if(took > _processMaxLatency) _processMaxLatency = took;
+  return state;
+}
+
+/**
+ * run one task slice and record its worst case time
+ * @since $dev
+ * @access private
+ * @param  wm_task_t task
+ * @return uint8_t WL_IDLE_STATUS, or save result
+ */
+uint8_t WiFiManager::runTask(wm_task_t task){
+  uint8_t state = WL_IDLE_STATUS;
+  unsigned long start = micros();
 
+  if(task == WM_TASK_DNS){
+    if(configPortalActive && dnsServer) dnsServer->processNextRequest();
+  }
+  else if(task == WM_TASK_HTTP){
+    if(server) processHTTP(); // own server only, a mounted portal is pumped by the app server
+  }
+  else if(task == WM_TASK_SAVE){
     // Waiting for save...
     if(connect) {
       connect = false;
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_VERBOSE,F("processing save"));
       #endif
-      if(_enableCaptivePortal) delay(_cpclosedelay); // keeps the captiveportal from closing to fast.
+      _saveAttempt    = 0;
+      _saveState      = _enableCaptivePortal ? SAVE_CLOSEDELAY : SAVE_CONNECT; // keeps the captiveportal from closing to fast.
+      timerArm(WM_TIMER_SAVE,_enableCaptivePortal ? _cpclosedelay : 0);
+    }
+    // advance save one step per slice, dns and http keep being served in between
+    if(_saveState != SAVE_IDLE) state = processSave();
+  }
+  else if(task == WM_TASK_MDNS){
+    #if defined(WM_MDNS) && defined(ESP8266)
+    MDNS.update();
+    #endif
+  }
+  else if(task == WM_TASK_RECONNECT){
+    processReconnect();
+  }
+
+  unsigned long took = micros() - start;
+  if(took > _taskMaxTime[task]) _taskMaxTime[task] = took;
+  return state;
+}
+
+/**
+ * check if the blocking portal has nothing to do, no clients associated, browsing or saving
+ * @since $dev
+ * @access private
+ * @return bool idle
+ */
+bool WiFiManager::configPortalIdle(){
+  if(connect || _saveState != SAVE_IDLE) return false;
+  if(_millis() - _webPortalAccessed < 2000) return false; // recently browsed, stay responsive
+  return WiFi_softap_num_stations() == 0;
+}
 
+/**
+ * arm a deadline timer, rearming restarts it
+ * all timeouts go through these slots, deadlines compare by elapsed time (millis()-start)
+ * so they survive the 49 day millis() rollover
+ * @since $dev
+ * @access private
+ * @param wm_timer_t id
+ * @param unsigned long interval ms until due
+ * @param unsigned long start ms armed, default now
+ */
+void WiFiManager::timerArm(wm_timer_t id, unsigned long interval){
+  timerArm(id,interval,_millis());
+}
+
+void WiFiManager::timerArm(wm_timer_t id, unsigned long interval, unsigned long start){
+  _timers[id].start    = start;
+  _timers[id].interval = interval;
+  _timers[id].armed    = true;
+  timerUpdateNext();
+}
+
+void WiFiManager::timerStop(wm_timer_t id){
+  if(!_timers[id].armed) return;
+  _timers[id].armed = false;
+  timerUpdateNext();
+}
+
+/**
+ * timer due
+ * @since $dev
+ * @access private
+ * @return bool true if armed and interval has elapsed, false if not armed
+ */
+bool WiFiManager::timerExpired(wm_timer_t id){
+  return _timers[id].armed && (_millis() - _timers[id].start >= _timers[id].interval);
+}
+
+/**
+ * periodic timer, for throttling
+ * @since $dev
+ * @access private
+ * @return bool true and rearms if not armed or due
+ */
+bool WiFiManager::timerEvery(wm_timer_t id, unsigned long interval){
+  if(_timers[id].armed && !timerExpired(id)) return false;
+  timerArm(id,interval);
+  return true;
+}
+
+/**
+ * ms since timer was armed
+ * @since $dev
+ * @access private
+ * @return unsigned long ms, ULONG_MAX if not armed
+ */
+unsigned long WiFiManager::timerElapsed(wm_timer_t id){
+  if(!_timers[id].armed) return ULONG_MAX;
+  return _millis() - _timers[id].start;
+}
+
+/**
+ * ms until timer is due
+ * @since $dev
+ * @access private
+ * @return unsigned long ms, 0 if due, ULONG_MAX if not armed
+ */
+unsigned long WiFiManager::timerRemaining(wm_timer_t id){
+  if(!_timers[id].armed) return ULONG_MAX;
+  unsigned long elapsed = _millis() - _timers[id].start;
+  return elapsed >= _timers[id].interval ? 0 : _timers[id].interval - elapsed;
+}
+
+/**
+ * cache the armed deadline due first, only called on arm and stop, passive timers are skipped
+ * relative order of armed deadlines does not change as time passes, so getNextDeadline stays O(1)
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::timerUpdateNext(){
+  unsigned long next = ULONG_MAX;
+  _timerNext = -1;
+  for(uint8_t i=0; i<_timerDeadlines; i++){
+    if(!_timers[i].armed) continue;
+    unsigned long remaining = timerRemaining((wm_timer_t)i);
+    if(_timerNext < 0 || remaining < next){
+      next       = remaining;
+      _timerNext = i;
+    }
+  }
+}
+
+/**
+ * autoConnect fast path, sta already associated or connecting from stored config at boot
+ * skips WiFi_Mode, enableSTA and begin, only applies the settings the full path would
+ * @since $dev
+ * @access private
+ * @return bool connected, false falls back to the full autoConnect path
+ */
+bool WiFiManager::autoConnectFast(){
+  if(!(WiFi.getMode() & WIFI_STA)) return false; // sta not started, nothing in flight
+  #ifdef ESP32
+  WiFi_initEvents(); // connecting is only known from sta events, see WiFi_isConnecting
+  // hostname is only applied when sta starts, a different one needs the full path restart
+  if(_hostname != "" && _hostname != WiFi.getHostname()) return false;
+  #endif
+
+  if(WiFi_status() != WL_CONNECTED){
+    if(!WiFi_isConnecting()) return false;
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("AutoConnect: STA already connecting, waiting"));
+    #endif
+    // bounded, a wrong guess must not fall into the core 60s wait before the full path
+    unsigned long wait = WM_FASTCONNECT_WAIT;
+    if(_connectTimeout > 0 && _connectTimeout < wait) wait = _connectTimeout;
+    if(waitForConnectResult(wait) != WL_CONNECTED) return false;
+  }
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(F("AutoConnect: ESP Already Connected"));
+  #endif
+  _begin();
+  WiFiSetCountry();
+  #ifdef ESP32
+  if(esp32persistent) WiFi.persistent(false);
+  #endif
+  _usermode = WIFI_STA;
+  WiFi_autoReconnect();
+  #ifdef ESP8266
+  if(_hostname != "") setupHostname(true);
+  #endif
+  setSTAConfig();
+  return true;
+}
+
+/**
+ * http client pump, drains queued clients under the process budget
+ * a client lingering after its response or stalled on read is closed when others are waiting
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::processHTTP(){
+  unsigned long start = _millis();
+  uint8_t served = 0;
+
+  #ifdef WM_ASYNCWEBSERVER
+  // connections are serviced by the async stack, only queued requests are handled here
+  WiFiManagerHTTPAsync *http = static_cast<WiFiManagerHTTPAsync*>(_http.get());
+  for(uint8_t i = 0; i < _httpPumpMax; i++){
+    unsigned long reqstart = micros();
+    if(!http->handle()) break;
+
+    unsigned long took = micros() - reqstart;
+    served++;
+    _httpstats.requests++;
+    _httpServiceTotal += took;
+    if(took > _httpstats.servicemax) _httpstats.servicemax = took;
+
+    if(!_http) break; // handler shut the portal down
+    if(_processBudget > 0 && _millis() - start >= _processBudget) break;
+  }
+  uint8_t depth = served + (_http ? http->pending() : 0);
+  if(depth > _httpstats.depthmax) _httpstats.depthmax = depth;
+  #else
+  WM_HTTPServer *pump = static_cast<WM_HTTPServer*>(server.get()); // always created as WM_HTTPServer, see setupHTTPServer
+  for(uint8_t i = 0; i < _httpPumpMax; i++){
+    if(_httpPumpMax > 1 && pump->clientPending()){
+      HTTPClientStatus status = pump->clientStatus();
+      if(status == HC_WAIT_CLOSE || (status == HC_WAIT_READ && _httpClientTimeout > 0 && pump->clientAge() > _httpClientTimeout)){
+        pump->clientDrop();
+        _httpstats.dropped++;
+      }
+    }
+
+    uint32_t requests = pump->requests();
+    unsigned long reqstart = micros();
+    server->handleClient();
+    if(!server) break; // handler shut the portal down
+    if(pump->requests() == requests) break; // idle or waiting on a client
+
+    unsigned long took = micros() - reqstart;
+    served++;
+    _httpstats.requests++;
+    _httpServiceTotal += took;
+    if(took > _httpstats.servicemax) _httpstats.servicemax = took;
+
+    if(!pump->clientPending()) break;
+    if(_processBudget > 0 && _millis() - start >= _processBudget) break;
+  }
+
+  uint8_t depth = served + ((served > 0 && server && pump->clientPending()) ? 1 : 0);
+  if(depth > _httpstats.depthmax) _httpstats.depthmax = depth;
+  #endif
+}
+
+/**
+ * non blocking save processor, steps through close delay, connect and wait
+ * @since $dev
+ * @access private
+ * @return uint8_t WL_IDLE_STATUS while pending, else processConfigPortal result
+ */
+uint8_t WiFiManager::processSave(){
+  if(_saveState == SAVE_CLOSEDELAY){
+    if(!timerExpired(WM_TIMER_SAVE)) return WL_IDLE_STATUS;
+    _saveState = SAVE_CONNECT;
+  }
+
+  if(_saveState == SAVE_CONNECT){
+    if(_saveAttempt == 0){
       // skip wifi if no ssid
       if(_ssid == ""){
         #ifdef WM_DEBUG_LEVEL
         DEBUG_WM(DEBUG_VERBOSE,F("No ssid, skipping wifi save"));
         #endif
+        return finishSave(false);
       }
-      else{
-        // attempt sta connection to submitted _ssid, _pass
-        uint8_t res = connectWifi(_ssid, _pass, _connectonsave) == WL_CONNECTED;
-        if (res || (!_connectonsave)) {
-          #ifdef WM_DEBUG_LEVEL
-          if(!_connectonsave){
-            DEBUG_WM(F("SAVED with no connect to new AP"));
-          } else {
-            DEBUG_WM(F("Connect to new AP [SUCCESS]"));
-            DEBUG_WM(F("Got IP Address:"));
-            DEBUG_WM(WiFi.localIP());
-          }
-          #endif
+      // explicit connect resets reconnect scheduler, new creds may fix a halted policy
+      _reconnAttempts = 0;
+      _reconnActive   = false;
+      _reconnHalted   = false;
+      setSTAConfig();
+      if(_cleanConnect) WiFi_Disconnect(); // disconnect before begin, in case anything is hung
+    }
+    else if(!timerExpired(WM_TIMER_SAVE)) return WL_IDLE_STATUS; // add idle time before recon
 
-          if ( _savewificallback != NULL) {
-            #ifdef WM_DEBUG_LEVEL
-            DEBUG_WM(DEBUG_VERBOSE,F("[CB] _savewificallback calling"));
-            #endif
-            _savewificallback(); // @CALLBACK
-          }
-          if(!_connectonsave) return WL_IDLE_STATUS;
-          if(_disableConfigPortal) shutdownConfigPortal();
-          return WL_CONNECTED; // CONNECT SUCCESS
-        }
-        #ifdef WM_DEBUG_LEVEL
-        DEBUG_WM(DEBUG_ERROR,F("[ERROR] Connect to new AP Failed"));
-        #endif
-      }
- 
-      if (_shouldBreakAfterConfig) {
+    _saveAttempt++;
+    #ifdef WM_DEBUG_LEVEL
+    if(_connectRetries > 1) DEBUG_WM(F("Connect Wifi, ATTEMPT #"),(String)_saveAttempt+" of "+(String)_connectRetries);
+    #endif
+    wifiConnectNew(_ssid,_pass,_connectonsave);
+    if(!_connectonsave) return finishSave(true); // save only, nothing to wait on
 
-        // do save callback
-        // @todo this is more of an exiting callback than a save, clarify when this should actually occur
-        // confirm or verify data was saved to make this more accurate callback
-        if ( _savewificallback != NULL) {
-          #ifdef WM_DEBUG_LEVEL
-          DEBUG_WM(DEBUG_VERBOSE,F("[CB] WiFi/Param save callback"));
-          #endif
-          _savewificallback(); // @CALLBACK
-        }
-        if(_disableConfigPortal) shutdownConfigPortal();
-        return WL_CONNECT_FAILED; // CONNECT FAIL
-      }
-      else if(_configPortalIsBlocking){
-        // clear save strings
-        _ssid = "";
-        _pass = "";
-        // if connect fails, turn sta off to stabilize AP
-        WiFi_Disconnect();
-        WiFi_enableSTA(false);
-        #ifdef WM_DEBUG_LEVEL
-        DEBUG_WM(DEBUG_VERBOSE,F("Processing - Disabling STA"));
-        #endif
-      }
-      else{
-        #ifdef WM_DEBUG_LEVEL
-        DEBUG_WM(DEBUG_VERBOSE,F("Portal is non blocking - remaining open"));
-        #endif        
-      }
+    // 60s matches the esp waitForConnectResult default used when no save timeout is set
+    _saveState = SAVE_WAIT;
+    timerArm(WM_TIMER_SAVE,_saveTimeout > 0 ? _saveTimeout : 60000);
+    return WL_IDLE_STATUS;
+  }
+
+  // SAVE_WAIT
+  uint8_t status = WiFi_status();
+  // flagged at save and the sdk reported no ap for this attempt, no retries
+  bool notfound = _saveNotFound && status == WL_NO_SSID_AVAIL && _connevtReason == WM_REASON_NO_AP_FOUND;
+  if(status != WL_CONNECTED && !WiFi_connectFailed(status) && !timerExpired(WM_TIMER_SAVE)) return WL_IDLE_STATUS;
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("Connection result:"),getWLStatusString(status));
+  #endif
+
+  if(status != WL_CONNECTED){
+    uint8_t retries = _connectRetries;
+    #ifdef ESP32
+    // assoc fail is often ap anti de-auth protection, allow extra attempts
+    if(_aggresiveReconn && _lastdisconnectreason == WIFI_REASON_ASSOC_FAIL) retries += 4;
+    #endif
+    #ifdef ESP8266
+    if(status == WL_WRONG_PASSWORD) retries = 0; // same password fails the same way
+    #endif
+    if(_saveAttempt < retries && !notfound){
+      _saveState = SAVE_CONNECT;
+      timerArm(WM_TIMER_SAVE,_aggresiveReconn ? 1000 : 0);
+      return WL_IDLE_STATUS;
     }
+  }
 
-    return WL_IDLE_STATUS;
+  updateConxResult(status);
+  #ifdef WM_DEBUG_LEVEL
+  if(status != WL_CONNECTED) DEBUG_WM(DEBUG_ERROR,F("[ERROR] Connect to new AP Failed"));
+  #endif
+  return finishSave(status == WL_CONNECTED);
+}
+
+/**
+ * check submitted creds against the last scan results
+ * ssids not in the scan are only flagged, hidden networks never show up
+ * @since $dev
+ * @access private
+ * @param  String ssid
+ * @param  String pass
+ * @return wm_savecheck_t, SAVECHECK_OK if no scan results are available
+ */
+WiFiManager::wm_savecheck_t WiFiManager::checkWifiSave(const String &ssid, const String &pass){
+  if(ssid == "" || !_lastscan || _numNetworks <= 0 || WiFi.scanComplete() < 0) return SAVECHECK_OK; // nothing to check against
+
+  wm_savecheck_t res = SAVECHECK_NOTFOUND;
+  size_t len = pass.length();
+  bool hex = len > 0;
+  for(size_t c = 0; c < len; c++){
+    if(!isxdigit(pass[c])) hex = false;
+  }
+
+  // same ssid may be served by several aps, any consistent one passes
+  for(int i = 0; i < _numNetworks; i++){
+    if(WiFi.SSID(i) != ssid) continue;
+    uint8_t enc_type = WiFi.encryptionType(i);
+    wm_savecheck_t check = SAVECHECK_OK;
+    if(enc_type == WM_WIFIOPEN){
+      if(len > 0) check = SAVECHECK_OPENPASS;
+    }
+    else if(len == 0) check = SAVECHECK_NOPASS;
+    else if(enc_type == WM_WIFIWEP){
+      // 40/104 bit keys, ascii or hex
+      if(!(len == 5 || len == 13 || (hex && (len == 10 || len == 26)))) check = SAVECHECK_BADPASS;
+    }
+    else if(len < 8 || len > 64 || (len == 64 && !hex)){
+      check = SAVECHECK_BADPASS; // wpa passphrase 8-63 ascii, or 64 hex psk
+    }
+    if(check == SAVECHECK_OK) return check;
+    if(res == SAVECHECK_NOTFOUND || check < res) res = check; // keep mildest failure
+  }
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("wifi save check:"),(String)res);
+  #endif
+  return res;
+}
+
+/**
+ * complete a save, run callbacks and portal teardown
+ * @since $dev
+ * @access private
+ * @param  bool success connected, or saved with _connectonsave off
+ * @return uint8_t WL_IDLE_STATUS, WL_CONNECTED or WL_CONNECT_FAILED
+ */
+uint8_t WiFiManager::finishSave(bool success){
+  _saveState = SAVE_IDLE;
+  timerStop(WM_TIMER_SAVE);
+  if(!success && _ssid != "") postPortalEvent(WM_EVT_CONNECTFAILED);
+
+  if(success){
+    #ifdef WM_DEBUG_LEVEL
+    if(!_connectonsave){
+      DEBUG_WM(F("SAVED with no connect to new AP"));
+    } else {
+      DEBUG_WM(F("Connect to new AP [SUCCESS]"));
+      DEBUG_WM(F("Got IP Address:"));
+      DEBUG_WM(WiFi.localIP());
+    }
+    #endif
+
+    if ( _savewificallback != NULL) {
+      #ifdef WM_DEBUG_LEVEL
+      DEBUG_WM(DEBUG_VERBOSE,F("[CB] _savewificallback calling"));
+      #endif
+      _savewificallback(); // @CALLBACK
+    }
+    if(!_connectonsave) return WL_IDLE_STATUS;
+    postPortalEvent(WM_EVT_CONNECTED);
+    if(_disableConfigPortal) shutdownConfigPortal();
+    return WL_CONNECTED; // CONNECT SUCCESS
+  }
+
+  if (_shouldBreakAfterConfig) {
+
+    // do save callback
+    // @todo this is more of an exiting callback than a save, clarify when this should actually occur
+    // confirm or verify data was saved to make this more accurate callback
+    if ( _savewificallback != NULL) {
+      #ifdef WM_DEBUG_LEVEL
+      DEBUG_WM(DEBUG_VERBOSE,F("[CB] WiFi/Param save callback"));
+      #endif
+      _savewificallback(); // @CALLBACK
+    }
+    if(_disableConfigPortal) shutdownConfigPortal();
+    return WL_CONNECT_FAILED; // CONNECT FAIL
+  }
+  else if(_configPortalIsBlocking){
+    // clear save strings
+    _ssid = "";
+    _pass = "";
+    // if connect fails, turn sta off to stabilize AP
+    WiFi_Disconnect();
+    WiFi_enableSTA(false);
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("Processing - Disabling STA"));
+    #endif
+  }
+  else{
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("Portal is non blocking - remaining open"));
+    #endif        
+  }
+  return WL_IDLE_STATUS;
 }
 
 /**
@@ -969,6 +2224,7 @@ bool WiFiManager::shutdownConfigPortal(){
   #endif
 
   if(webPortalActive) return false;
+  unsigned long shutdownstart = _millis();
 
   if(configPortalActive){
     //DNS handler
@@ -976,12 +2232,37 @@ bool WiFiManager::shutdownConfigPortal(){
   }
 
   //HTTP handler
-  server->handleClient();
+  // a persistent server keeps listening, handleRoute answers 503 until the portal starts again
+  // nothing calls process() after a blocking config portal returns, its kept server stops listening instead of leaving clients unanswered
+  #ifdef WM_ASYNCWEBSERVER
+  processHTTP();
+  if(!_httpPersistent){
+    server->end();
+    _http.reset();
+    server.reset();
+  }
+  else if(configPortalActive && _configPortalIsBlocking){
+    server->end();
+    _httpServerClosed = true;
+  }
+  #else
+  if(_mountHandler) unmountWebPortal(); // mounted on an app server, only the portal routes go
+  else {
+    server->handleClient();
 
-  // @todo what is the proper way to shutdown and free the server up
-  // debug - many open issues aobut port not clearing for use with other servers
-  server->stop();
-  server.reset();
+    // @todo what is the proper way to shutdown and free the server up
+    // debug - many open issues aobut port not clearing for use with other servers
+    if(!_httpPersistent){
+      server->stop();
+      _http.reset();
+      server.reset();
+    }
+    else if(configPortalActive && _configPortalIsBlocking){
+      server->stop();
+      _httpServerClosed = true;
+    }
+  }
+  #endif
 
   WiFi.scanDelete(); // free wifi scan results
 
@@ -1003,9 +2284,10 @@ bool WiFiManager::shutdownConfigPortal(){
   if(!ret)DEBUG_WM(DEBUG_ERROR,F("[ERROR] disconnect configportal - softAPdisconnect FAILED"));
   DEBUG_WM(DEBUG_VERBOSE,F("restoring usermode"),getModeString(_usermode));
   #endif
-  delay(1000);
+  // let the ap deauth its clients before changing mode, replaces a fixed 1s delay
+  if(ret) WiFi_waitAPIdle(1000);
   WiFi_Mode(_usermode); // restore users wifi mode, BUG https://github.com/esp8266/Arduino/issues/4372
-  if(WiFi.status()==WL_IDLE_STATUS){
+  if(WiFi_status()==WL_IDLE_STATUS){
     WiFi.reconnect(); // restart wifi since we disconnected it in startconfigportal
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM(DEBUG_VERBOSE,F("WiFi Reconnect, was idle"));
@@ -1016,7 +2298,10 @@ bool WiFiManager::shutdownConfigPortal(){
   DEBUG_WM(DEBUG_VERBOSE,F("wifi mode:"),getModeString(WiFi.getMode()));
   #endif
   configPortalActive = false;
-  DEBUG_WM(DEBUG_VERBOSE,F("configportal closed"));
+  timerStop(WM_TIMER_PORTAL);
+  timerStop(WM_TIMER_LOG);
+  _portalShutdownDuration = _millis() - shutdownstart;
+  DEBUG_WM(DEBUG_VERBOSE,F("configportal closed in"),(String)_portalShutdownDuration + " ms");
   _end();
   return ret;
 }
@@ -1029,8 +2314,14 @@ uint8_t WiFiManager::connectWifi(String ssid, String pass, bool connect) {
   DEBUG_WM(DEBUG_VERBOSE,F("Connecting as wifi client..."));
   #endif
   uint8_t retry = 1;
+  uint8_t retries = _connectRetries; // local, may be extended on assoc failures
   uint8_t connRes = (uint8_t)WL_NO_SSID_AVAIL;
 
+  // explicit connect resets reconnect scheduler, new creds may fix a halted policy
+  _reconnAttempts = 0;
+  _reconnActive   = false;
+  _reconnHalted   = false;
+
   setSTAConfig();
   //@todo catch failures in set_config
   
@@ -1043,11 +2334,11 @@ uint8_t WiFiManager::connectWifi(String ssid, String pass, bool connect) {
   // E (5130) wifi:sta is connecting, return error
   // [E][WiFiSTA.cpp:221] begin(): connect failed!
 
-  while(retry <= _connectRetries && (connRes!=WL_CONNECTED)){
-  if(_connectRetries > 1){
-    if(_aggresiveReconn) delay(1000); // add idle time before recon
+  while(retry <= retries && (connRes!=WL_CONNECTED)){
+  if(retries > 1){
+    if(_aggresiveReconn) _delay(1000); // add idle time before recon
     #ifdef WM_DEBUG_LEVEL
-      DEBUG_WM(F("Connect Wifi, ATTEMPT #"),(String)retry+" of "+(String)_connectRetries); 
+      DEBUG_WM(F("Connect Wifi, ATTEMPT #"),(String)retry+" of "+(String)retries); 
       #endif
   }
   // if ssid argument provided connect to that
@@ -1081,6 +2372,13 @@ uint8_t WiFiManager::connectWifi(String ssid, String pass, bool connect) {
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_VERBOSE,F("Connection result:"),getWLStatusString(connRes));
   #endif
+
+  #ifdef ESP32
+  // assoc fail is often ap anti de-auth protection, extend retries for this connect only
+  if(_aggresiveReconn && connRes != WL_CONNECTED && _lastdisconnectreason == WIFI_REASON_ASSOC_FAIL && retries == _connectRetries){
+    retries += 4;
+  }
+  #endif
   retry++;
 }
 
@@ -1119,7 +2417,8 @@ bool WiFiManager::wifiConnectNew(String ssid, String pass,bool connect){
   #endif
   WiFi_enableSTA(true,storeSTAmode); // storeSTAmode will also toggle STA on in default opmode (persistent) if true (default)
   WiFi.persistent(true);
-  ret = WiFi.begin(ssid.c_str(), pass.c_str(), 0, NULL, connect);
+  connTimingBegin();
+  ret = WiFi_begin(ssid.c_str(), pass.c_str(), connect);
   WiFi.persistent(false);
   #ifdef WM_DEBUG_LEVEL
   if(!ret) DEBUG_WM(DEBUG_ERROR,F("[ERROR] wifi begin failed"));
@@ -1141,14 +2440,15 @@ bool WiFiManager::wifiConnectDefault(){
   #endif
 
   ret = WiFi_enableSTA(true,storeSTAmode);
-  delay(500); // THIS DELAY ?
+  if(ret) WiFi_waitMode(WIFI_STA,500); // mode change is async on some cores, was a fixed 500ms delay
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Mode after delay: "),getModeString(WiFi.getMode()));
   if(!ret) DEBUG_WM(DEBUG_ERROR,F("[ERROR] wifi enableSta failed"));
   #endif
 
-  ret = WiFi.begin();
+  connTimingBegin();
+  ret = WiFi_begin();
 
   #ifdef WM_DEBUG_LEVEL
   if(!ret) DEBUG_WM(DEBUG_ERROR,F("[ERROR] wifi begin failed"));
@@ -1221,6 +2521,172 @@ void WiFiManager::updateConxResult(uint8_t status){
       }
     DEBUG_WM(DEBUG_DEV,F("lastconxresult:"),getWLStatusString(_lastconxresult));
     #endif
+  connTimingEnd(_lastconxresult);
+}
+
+/**
+ * open a new connect timing record, call right before WiFi.begin
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::connTimingBegin(){
+  if(_conntimingOpen) connTimingEnd(WiFi_status()); // retried without a result
+  #ifdef ESP32
+  _lastdisconnectreason = 0; // reason from an earlier attempt must not drive this one
+  #endif
+  _conntimingHead = (_conntimingHead + 1) % WM_CONNTIMING_SIZE;
+  if(_conntimingCount < WM_CONNTIMING_SIZE) _conntimingCount++;
+  _conntiming[_conntimingHead] = wm_conntiming_t();
+  _conntiming[_conntimingHead].start = _millis();
+  _connevtConnected = 0;
+  _connevtGotIP     = 0;
+  _connevtReason    = 0;
+  _conntimingOpen = true;
+}
+
+/**
+ * stamp a connect phase from wifi events
+ * runs in the esp32 event task, only stores stamps, no records, logging or clock hook
+ * @since $dev
+ * @access private
+ * @param  wm_connphase_t phase
+ * @param  uint8_t reason disconnect reason
+ */
+void WiFiManager::connTimingEvent(wm_connphase_t phase, uint8_t reason){
+  unsigned long now = millis();
+  if(now == 0) now = 1; // 0 is not seen
+
+  if(phase == CONNPHASE_CONNECTED){
+    if(_connevtConnected == 0) _connevtConnected = now;
+  }
+  else if(phase == CONNPHASE_GOTIP){
+    if(_connevtConnected == 0) _connevtConnected = now;
+    _connevtGotIP = now;
+  }
+  else if(phase == CONNPHASE_DISCONNECTED){
+    _connevtReason = reason;
+  }
+}
+
+/**
+ * copy event stamps into the open timing record
+ * events stamp millis(), each stamp is mapped onto the _millis() clock by its age
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::connTimingCollect(){
+  wm_conntiming_t &t = _conntiming[_conntimingHead];
+  unsigned long connected = _connevtConnected;
+  unsigned long gotip     = _connevtGotIP;
+  uint8_t       reason    = _connevtReason;
+  unsigned long now       = millis();
+  unsigned long elapsed   = _millis() - t.start;
+  if(connected && t.connected == 0) t.connected = connTimingSince(elapsed, now - connected);
+  if(gotip && t.gotip == 0) t.gotip = connTimingSince(elapsed, now - gotip);
+  if(reason) t.reason = reason;
+}
+
+// ms from attempt start to a stamp age ms old, 0 is phase not reached so at least 1
+unsigned long WiFiManager::connTimingSince(unsigned long elapsed, unsigned long age){
+  return age < elapsed ? elapsed - age : 1;
+}
+
+/**
+ * loop side of connect timing, got ip seen by the event handlers closes the attempt
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::connTimingPoll(){
+  if(!_conntimingOpen) return;
+  connTimingCollect();
+  if(_conntiming[_conntimingHead].gotip) connTimingEnd(WL_CONNECTED);
+}
+
+/**
+ * close the open connect timing record with its result
+ * @since $dev
+ * @access private
+ * @param  uint8_t status
+ */
+void WiFiManager::connTimingEnd(uint8_t status){
+  if(!_conntimingOpen) return;
+  connTimingCollect();
+  wm_conntiming_t &t = _conntiming[_conntimingHead];
+  t.total  = _millis() - t.start;
+  t.status = status;
+  _conntimingOpen = false;
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("[CONN] timing link/ip/total ms:"),(String)t.connected + "/" + (String)t.gotip + "/" + (String)t.total);
+  #endif
+  connStatsRecord(t);
+}
+
+/**
+ * read connect stats from rtc memory once, zeroed on cold boot or without WM_CONNSTATS_RTC
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::connStatsLoad(){
+  if(_connstatsLoaded) return;
+  _connstatsLoaded = true;
+  #ifndef WM_CONNSTATS_RTC
+  _connstats = wm_connstats_t(); // ram only, rtc user memory is left to the sketch
+  #else
+  wm_connstats_rtc_t rtc;
+  rtc.magic = 0;
+  #ifdef ESP8266
+  if(!ESP.rtcUserMemoryRead(WM_CONNSTATS_RTCOFFSET,(uint32_t*)&rtc,sizeof(rtc))) rtc.magic = 0;
+  #elif defined(ESP32)
+  rtc = wm_connstats_rtc;
+  #endif
+  if(rtc.magic == WM_CONNSTATS_MAGIC && rtc.check == wm_connstats_check(rtc.stats)){
+    _connstats = rtc.stats;
+  }
+  else _connstats = wm_connstats_t();
+  #endif
+}
+
+/**
+ * write connect stats to rtc memory, no flash wear, no-op without WM_CONNSTATS_RTC
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::connStatsSave(){
+  #ifdef WM_CONNSTATS_RTC
+  wm_connstats_rtc_t rtc;
+  rtc.magic = WM_CONNSTATS_MAGIC;
+  rtc.stats = _connstats;
+  rtc.check = wm_connstats_check(rtc.stats);
+  #ifdef ESP8266
+  ESP.rtcUserMemoryWrite(WM_CONNSTATS_RTCOFFSET,(uint32_t*)&rtc,sizeof(rtc));
+  #elif defined(ESP32)
+  wm_connstats_rtc = rtc;
+  #endif
+  #endif
+}
+
+/**
+ * count a finished connect attempt by result, reason and duration
+ * @since $dev
+ * @access private
+ * @param  wm_conntiming_t t closed timing record
+ */
+void WiFiManager::connStatsRecord(const wm_conntiming_t &t){
+  connStatsLoad();
+
+  wm_connstats_inc(_connstats.status[t.status < 8 ? t.status : 8]);
+
+  uint8_t reason = 25; // other
+  if(t.reason <= 24) reason = t.reason;
+  else if(t.reason >= 200 && t.reason <= 209) reason = 26 + (t.reason - 200);
+  wm_connstats_inc(_connstats.reason[reason]);
+
+  uint8_t bin = 0;
+  while(bin < 7 && t.total >= (500UL << bin)) bin++;
+  if(t.status == WL_CONNECTED) wm_connstats_inc(_connstats.connected[bin]);
+  else wm_connstats_inc(_connstats.failed[bin]);
+
+  connStatsSave();
 }
 
  
@@ -1237,33 +2703,152 @@ uint8_t WiFiManager::waitForConnectResult() {
  * @return uint8_t  WL Status
  */
 uint8_t WiFiManager::waitForConnectResult(uint32_t timeout) {
-  if (timeout == 0){
+  if (timeout == 0 && !_statusfunc){
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM(F("connectTimeout not set, ESP waitForConnectResult..."));
     #endif
     return WiFi.waitForConnectResult();
   }
+  if (timeout == 0) timeout = 60000; // core default, a simulated status needs the wait loop
 
-  unsigned long timeoutmillis = millis() + timeout;
+  timerArm(WM_TIMER_CONNECT,timeout);
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_VERBOSE,timeout,F("ms timeout, waiting for connect..."));
   #endif
-  uint8_t status = WiFi.status();
+  uint8_t status = WiFi_status();
   
-  while(millis() < timeoutmillis) {
-    status = WiFi.status();
+  while(!timerExpired(WM_TIMER_CONNECT)) {
+    connTimingPoll();
+    status = WiFi_status();
     // @todo detect additional states, connect happens, then dhcp then get ip, there is some delay here, make sure not to timeout if waiting on IP
     if (status == WL_CONNECTED || status == WL_CONNECT_FAILED) {
-      return status;
+      break;
     }
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM (DEBUG_VERBOSE,F("."));
     #endif
-    delay(100);
+    _delay(100);
   }
+  timerStop(WM_TIMER_CONNECT);
   return status;
 }
 
+/**
+ * processReconnect
+ * non blocking reconnect scheduler, called from process()
+ * tracks one attempt at a time, on failure picks next interval from getReconnectPolicy
+ * never waits, only reads status and calls begin
+ * @since $dev
+ */
+void WiFiManager::processReconnect(){
+  if(!_reconnBackoff || configPortalActive || _saveState != SAVE_IDLE) return; // do not fight the softap or a portal save for the radio
+
+  uint8_t status = WiFi_status();
+  if(status == WL_CONNECTED){
+    #ifdef WM_DEBUG_LEVEL
+    if(_reconnAttempts > 0) DEBUG_WM(DEBUG_VERBOSE,F("[RECONN] connected after attempts:"),_reconnAttempts);
+    #endif
+    connTimingEnd(WL_CONNECTED); // no-op if got ip event already closed it
+    #ifdef ESP32
+    _lastdisconnectreason = 0;
+    #endif
+    _reconnAttempts = 0;
+    _reconnDelay    = 0;
+    _reconnActive   = false;
+    timerStop(WM_TIMER_RECONNECT);
+    return;
+  }
+
+  if(_reconnHalted) return;
+
+  if(_reconnActive){
+    if(!WiFi_connectFailed(status) && !timerExpired(WM_TIMER_RECONNECT)) return; // still connecting
+    _reconnActive = false;
+    updateConxResult(status);
+    scheduleReconnect();
+    return;
+  }
+
+  // first drop after being connected, start backoff from here
+  if(_reconnDelay == 0){
+    if(!WiFi_hasAutoConnect()) return; // nothing saved to reconnect to
+    updateConxResult(status);
+    scheduleReconnect();
+    if(_reconnHalted) return;
+  }
+
+  if(!timerExpired(WM_TIMER_RECONNECT)) return;
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("[RECONN] attempt #"),_reconnAttempts+1);
+  #endif
+  WiFi_enableSTA(true);
+  connTimingBegin();
+  WiFi_begin(); // stored config, returns immediately
+  _reconnActive = true;
+  timerArm(WM_TIMER_RECONNECT,_connectTimeout > 0 ? _connectTimeout : 15000);
+}
+
+/**
+ * classify the last connection failure into a reconnect policy
+ * @since $dev
+ * @return wm_reconnpolicy_t
+ */
+WiFiManager::wm_reconnpolicy_t WiFiManager::getReconnectPolicy(){
+  #ifdef ESP32
+    switch(_lastdisconnectreason){
+      case WIFI_REASON_AUTH_FAIL:
+      case WIFI_REASON_AUTH_EXPIRE:
+      case WIFI_REASON_4WAY_HANDSHAKE_TIMEOUT:
+      case WIFI_REASON_HANDSHAKE_TIMEOUT:
+        return RECONN_STOP;
+      case WIFI_REASON_NO_AP_FOUND:
+        return RECONN_SLOW;
+      case WIFI_REASON_ASSOC_FAIL:
+      case WIFI_REASON_ASSOC_EXPIRE:
+        return RECONN_FAST;
+    }
+  #endif
+  if(_lastconxresult == WL_STATION_WRONG_PASSWORD) return RECONN_STOP;
+  #ifdef ESP8266
+  if(_lastconxresult == WL_WRONG_PASSWORD) return RECONN_STOP; // reported directly by newer cores, see processSave
+  #endif
+  if(_lastconxresult == WL_NO_SSID_AVAIL) return RECONN_SLOW;
+  return RECONN_RETRY;
+}
+
+/**
+ * set next reconnect interval, exponential backoff with jitter, capped at _reconnMax
+ * @since $dev
+ */
+void WiFiManager::scheduleReconnect(){
+  wm_reconnpolicy_t policy = getReconnectPolicy();
+
+  if(policy == RECONN_STOP){
+    _reconnHalted = true;
+    timerStop(WM_TIMER_RECONNECT);
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_NOTIFY,F("[RECONN] wrong password, reconnect halted"));
+    #endif
+    return;
+  }
+
+  uint8_t shift = _reconnAttempts;
+  if(policy == RECONN_FAST) shift = _reconnAttempts < _reconnFastRetries ? 0 : _reconnAttempts - _reconnFastRetries;
+  else if(policy == RECONN_SLOW) shift += 2; // 4x
+  if(shift > 16) shift = 16; // overflow guard, cap applies long before
+
+  unsigned long interval = _reconnMin << shift;
+  if(interval > _reconnMax || interval < _reconnMin) interval = _reconnMax;
+  _reconnDelay = interval - (interval/4) + random(interval/2 + 1); // +-25% jitter, desync fleets after ap reboot
+  if(_reconnAttempts < 255) _reconnAttempts++;
+  timerArm(WM_TIMER_RECONNECT,_reconnDelay);
+
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("[RECONN] policy:"),(String)policy + " next in " + (String)_reconnDelay + " ms");
+  #endif
+}
+
 // WPS enabled? https://github.com/esp8266/Arduino/pull/4889
 #ifdef NO_EXTRA_4K_HEAP
 void WiFiManager::startWPS() {
@@ -1281,35 +2866,280 @@ void WiFiManager::startWPS() {
 }
 #endif
 
-String WiFiManager::getHTTPHead(String title){
-  String page;
-  page += FPSTR(HTTP_HEAD_START);
-  page.replace(FPSTR(T_v), title);
-  page += FPSTR(HTTP_SCRIPT);
-  page += FPSTR(HTTP_STYLE);
-  page += _customHeadElement;
+void WiFiManager::HTTPSendHead(const String &title){
+  String head = FPSTR(HTTP_HEAD_START);
+  head.replace(FPSTR(T_v), title);
+  HTTPSendS(head);
+  HTTPSendP(HTTP_SCRIPT);
+  HTTPSendP(HTTP_STYLE);
+  if(*_customHeadElement) HTTPSendS(_customHeadElement);
 
   if(_bodyClass != ""){
     String p = FPSTR(HTTP_HEAD_END);
     p.replace(FPSTR(T_c), _bodyClass); // add class str
-    page += p;
+    HTTPSendS(p);
   }
   else {
-    page += FPSTR(HTTP_HEAD_END);
+    HTTPSendP(HTTP_HEAD_END);
   } 
-
-  return page;
 }
 
 void WiFiManager::HTTPSend(const String &content){
-  server->send(200, FPSTR(HTTP_HEAD_CT), content);
+  _http->send(200, FPSTR(HTTP_HEAD_CT), content);
+}
+
+/**
+ * chunked page writer, static PROGMEM segments go from flash straight to the client
+ * dynamic segments are coalesced into WM_SENDBUF_SIZE pieces, page size no longer costs heap
+ * HTTPSendBegin, then any mix of HTTPSendP / HTTPSendS, then HTTPSendEnd
+ * headers must be set before HTTPSendBegin
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::HTTPSendBegin(int code){
+  if(_httpCompression && _http->header(FPSTR(HTTP_HEAD_ACCEPTENC)).indexOf(FPSTR(HTTP_HEAD_GZIP)) >= 0){
+    // whole page goes through the encoder, it emits mss sized pieces so _sendbuf is not used
+    _deflate.reset(new WiFiManagerDeflate([this](const uint8_t *data, size_t len){
+      _http->sendContent((const char*)data,len);
+    }));
+    _http->sendHeader(FPSTR(HTTP_HEAD_CONTENTENC), FPSTR(HTTP_HEAD_GZIP)); // @HTTPHEAD send gzip
+    _http->sendHeader(FPSTR(HTTP_HEAD_VARY), FPSTR(HTTP_HEAD_ACCEPTENC));
+  }
+  else _sendbuf.reserve(WM_SENDBUF_SIZE);
+  _http->sendChunked(code, FPSTR(HTTP_HEAD_CT));
+}
+
+void WiFiManager::HTTPSendP(PGM_P content){
+  if(pgm_read_byte(content) == 0) return; // empty chunk would end the response
+  if(_httpPrefix.length() > 0){
+    HTTPSendS(FPSTR(content)); // links need the mount prefix
+    return;
+  }
+  if(_deflate){
+    unsigned long start = micros();
+    _deflate->write_P(content,strlen_P(content));
+    _httpstats.gziptime += micros() - start;
+    return;
+  }
+  HTTPSendFlush();
+  _http->sendContent_P(content);
+}
+
+void WiFiManager::HTTPSendS(const String &content){
+  // mounted under a prefix, absolute links and form actions are moved under it
+  const String *out = &content;
+  String prefixed;
+  if(_httpPrefix.length() > 0 && content.indexOf(F("='/")) >= 0){
+    prefixed = content;
+    prefixed.replace(F("='/"), (String)F("='") + _httpPrefix + F("/"));
+    out = &prefixed;
+  }
+  if(_deflate){
+    unsigned long start = micros();
+    _deflate->write((const uint8_t*)out->c_str(),out->length());
+    _httpstats.gziptime += micros() - start;
+    return;
+  }
+  _sendbuf += *out;
+  if(_sendbuf.length() >= WM_SENDBUF_SIZE) HTTPSendFlush();
+}
+
+void WiFiManager::HTTPSendFlush(){
+  if(_sendbuf.length() == 0) return;
+  _http->sendContent(_sendbuf.c_str(), _sendbuf.length());
+  _sendbuf = "";
+}
+
+void WiFiManager::HTTPSendEnd(){
+  if(_deflate){
+    unsigned long start = micros();
+    _deflate->finish();
+    _httpstats.gziptime += micros() - start;
+    _httpstats.gzipped++;
+    _httpstats.gzipin  += _deflate->totalIn();
+    _httpstats.gzipout += _deflate->totalOut();
+    _deflate.reset();
+  }
+  HTTPSendFlush();
+  _http->sendChunkedEnd();
+  _sendbuf = String(); // free
+}
+
+#ifndef WM_ASYNCWEBSERVER
+  #define WM_ROUTE_UPDATE(ROUTE) ROUTE(R_update, WM_ROUTE_GET, handleUpdate)
+#else
+  // the upload is written from the async context, the done page is queued like any other request
+  #define WM_ROUTE_UPDATE(ROUTE) ROUTE(R_update, WM_ROUTE_GET, handleUpdate) ROUTE(R_updatedone, WM_ROUTE_POST, handleUpdateDone)
+#endif
+
+// portal routes, expanded into the route table and its dispatch slots
+// saves take GET too, the forms post but scripts and older pages send query strings
+#define WM_ROUTES(ROUTE) \
+  ROUTE(R_root,       WM_ROUTE_GET,     handleRoot) \
+  ROUTE(R_wifi,       WM_ROUTE_GETPOST, handleWifiScan) \
+  ROUTE(R_wifinoscan, WM_ROUTE_GET,     handleWifiNoScan) \
+  ROUTE(R_wifisave,   WM_ROUTE_GETPOST, handleWifiSave) \
+  ROUTE(R_info,       WM_ROUTE_GET,     handleInfo) \
+  ROUTE(R_param,      WM_ROUTE_GET,     handleParam) \
+  ROUTE(R_paramsave,  WM_ROUTE_GETPOST, handleParamSave) \
+  ROUTE(R_restart,    WM_ROUTE_GET,     handleReset) \
+  ROUTE(R_exit,       WM_ROUTE_GET,     handleExit) \
+  ROUTE(R_close,      WM_ROUTE_GET,     handleClose) \
+  ROUTE(R_erase,      WM_ROUTE_GET,     handleEraseWifi) \
+  ROUTE(R_status,     WM_ROUTE_GET,     handleWiFiStatus) \
+  WM_ROUTE_UPDATE(ROUTE)
+
+#define WM_ROUTE_PATH(path, methods, handler)  path,
+#define WM_ROUTE_ENTRY(path, methods, handler) { path, routeLen(path), routeHash(path), methods, &WiFiManager::handler },
+
+static constexpr const char * wm_routepaths[] = { WM_ROUTES(WM_ROUTE_PATH) };
+#define WM_ROUTES_COUNT (sizeof(wm_routepaths) / sizeof(wm_routepaths[0]))
+
+// portal route table, constant initialized, hashes are computed at compile time
+const WiFiManager::wm_route_t WiFiManager::_routes[] = { WM_ROUTES(WM_ROUTE_ENTRY) };
+
+// dispatch slots, hash to route in one lookup, see findRoute
+#define WM_ROUTE_SLOT(n) routeSlotIndex(n, wm_routepaths, WM_ROUTES_COUNT)
+const uint8_t WiFiManager::_routeSlots[32] = {
+  WM_ROUTE_SLOT(0),  WM_ROUTE_SLOT(1),  WM_ROUTE_SLOT(2),  WM_ROUTE_SLOT(3),  WM_ROUTE_SLOT(4),  WM_ROUTE_SLOT(5),  WM_ROUTE_SLOT(6),  WM_ROUTE_SLOT(7),
+  WM_ROUTE_SLOT(8),  WM_ROUTE_SLOT(9),  WM_ROUTE_SLOT(10), WM_ROUTE_SLOT(11), WM_ROUTE_SLOT(12), WM_ROUTE_SLOT(13), WM_ROUTE_SLOT(14), WM_ROUTE_SLOT(15),
+  WM_ROUTE_SLOT(16), WM_ROUTE_SLOT(17), WM_ROUTE_SLOT(18), WM_ROUTE_SLOT(19), WM_ROUTE_SLOT(20), WM_ROUTE_SLOT(21), WM_ROUTE_SLOT(22), WM_ROUTE_SLOT(23),
+  WM_ROUTE_SLOT(24), WM_ROUTE_SLOT(25), WM_ROUTE_SLOT(26), WM_ROUTE_SLOT(27), WM_ROUTE_SLOT(28), WM_ROUTE_SLOT(29), WM_ROUTE_SLOT(30), WM_ROUTE_SLOT(31)
+};
+
+#define WM_PROBE(path, os, online) { path, routeLen(path), routeHash(path), os, online, sizeof(online) - 1 }
+
+// os captive portal probes, phones repeat these several times a second while the portal is up
+const WiFiManager::wm_proberoute_t WiFiManager::_probes[] = {
+  WM_PROBE(R_probeandroid,  WM_PROBE_ANDROID, HTTP_PROBE_204),
+  WM_PROBE(R_probeandroid2, WM_PROBE_ANDROID, HTTP_PROBE_204),
+  WM_PROBE(R_probeapple,    WM_PROBE_APPLE,   HTTP_PROBE_APPLE),
+  WM_PROBE(R_probeapple2,   WM_PROBE_APPLE,   HTTP_PROBE_APPLE),
+  WM_PROBE(R_probewindows,  WM_PROBE_WINDOWS, HTTP_PROBE_WINDOWS),
+  WM_PROBE(R_probewindows2, WM_PROBE_WINDOWS, HTTP_PROBE_NCSI),
+  WM_PROBE(R_probefirefox,  WM_PROBE_FIREFOX, HTTP_PROBE_FIREFOX)
+};
+const uint8_t WiFiManager::_probesCount = sizeof(_probes) / sizeof(_probes[0]);
+
+/**
+ * HTTPD dispatcher for portal routes, single handler instead of one core handler per route
+ * matches on length and hash, then confirms the path, unknown uris go to handleNotFound
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::handleRoute() {
+  if(!_http || handleStopped()) return;
+  unsigned long start = micros();
+  const char *path = routePath(_http->uri());
+  size_t len = strlen(path);
+  uint32_t hash = routeHash(path);
+  const wm_route_t *route = findRoute(path, hash, len);
+
+  unsigned long took = micros() - start;
+  if(took > _httpstats.dispatchmax) _httpstats.dispatchmax = took;
+
+  if(route && !(route->methods & routeMethod())){
+    _http->sendHeader(F("Allow"), (route->methods & WM_ROUTE_POST) ? F("GET, HEAD, POST") : F("GET, HEAD"));
+    _http->send(405, FPSTR(HTTP_HEAD_CT2), "");
+  }
+  else if(route) (this->*(route->handler))();
+  else if(_httpPrefix.length() > 0 || !handleProbe(path, hash, len)) handleNotFound(); // probes only at root
+}
+
+/**
+ * a persistent server keeps listening while the portal is stopped, its requests get a 503
+ * @since $dev
+ * @access private
+ * @return bool true if the request was answered
+ */
+bool WiFiManager::handleStopped(){
+  if(configPortalActive || webPortalActive) return false;
+  if(!_http) return true; // no backend left to answer on
+  _http->send(503, FPSTR(HTTP_HEAD_CT2), "");
+  return true;
+}
+
+/**
+ * portal path of a request uri, the mount prefix stripped
+ * @since $dev
+ * @access private
+ */
+const char * WiFiManager::routePath(const String &uri){
+  if(_httpPrefix.length() == 0 || !uri.startsWith(_httpPrefix)) return uri.c_str();
+  const char *path = uri.c_str() + _httpPrefix.length();
+  return *path ? path : "/";
+}
+
+const WiFiManager::wm_route_t * WiFiManager::findRoute(const char *path, uint32_t hash, size_t len){
+  static_assert(routeSlotsUnique(wm_routepaths, WM_ROUTES_COUNT), "portal routes share a dispatch slot, adjust routeSlot");
+  uint8_t i = _routeSlots[routeSlot(hash)];
+  if(i == 0) return NULL;
+  const wm_route_t *route = &_routes[i - 1];
+  if(route->hash == hash && route->len == len && strcmp_P(path, route->path) == 0) return route; // other uris share slots
+  return NULL;
+}
+
+/**
+ * method of the current request as WM_ROUTE_ flags, 0 for methods no route takes
+ * @since $dev
+ * @access private
+ */
+uint8_t WiFiManager::routeMethod(){
+  WM_HTTPMethod method = _http->method();
+  if(method == HTTP_GET || method == HTTP_HEAD) return WM_ROUTE_GET;
+  if(method == HTTP_POST) return WM_ROUTE_POST;
+  return 0;
+}
+
+/**
+ * HTTPD fast path for os captive portal probes, no Strings and no arg dump
+ * redirects to the portal with the prebuilt 302 while the captive portal is up,
+ * answers what the os expects from the internet once it is closed or creds were saved
+ * @param  path,hash,len of the uri, from handleRoute
+ * @return true if answered
+ * @since $dev
+ * @access private
+ */
+bool WiFiManager::handleProbe(const char *path, uint32_t hash, uint8_t len) {
+  const wm_proberoute_t *probe = NULL;
+  for(uint8_t i = 0; i < _probesCount; i++){
+    if(_probes[i].hash == hash && _probes[i].len == len && strcmp_P(path, _probes[i].path) == 0){
+      probe = &_probes[i];
+      break;
+    }
+  }
+  if(!probe) return false;
+
+  bool redirect = _enableCaptivePortal && _saveState == SAVE_IDLE && _cpRedirectLen > 0;
+  if(redirect){
+    _http->sendRaw((const uint8_t*)_cpRedirect, _cpRedirectLen);
+    _httpstats.proberedirects++;
+  }
+  else _http->sendRaw_P(probe->online, probe->onlinelen);
+  _httpstats.probes[probe->os]++;
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_MAX,redirect ? F("<- probe redirected") : F("<- probe online"));
+  #endif
+  return true;
+}
+
+void WiFiManager::handleWifiScan() {
+  handleWifi(true);
+}
+
+void WiFiManager::handleWifiNoScan() {
+  handleWifi(false);
+}
+
+void WiFiManager::handleEraseWifi() {
+  handleErase(false);
 }
 
 /** 
  * HTTPD handler for page requests
  */
 void WiFiManager::handleRequest() {
-  _webPortalAccessed = millis();
+  _webPortalAccessed = _millis();
 
   // TESTING HTTPD AUTH RFC 2617
   // BASIC_AUTH will hold onto creds, hard to "logout", but convienent
@@ -1322,6 +3152,7 @@ void WiFiManager::handleRequest() {
   bool testauth = false;
   if(!testauth) return;
   
+  #ifndef WM_ASYNCWEBSERVER
   DEBUG_WM(DEBUG_DEV,F("DOING AUTH"));
   bool res = server->authenticate("admin","12345");
   if(!res){
@@ -1330,6 +3161,7 @@ void WiFiManager::handleRequest() {
     #endif
     DEBUG_WM(DEBUG_DEV,F("AUTH FAIL"));
   }
+  #endif
 }
 
 /** 
@@ -1343,17 +3175,19 @@ void WiFiManager::handleRoot() {
   _WifiAP_active = true;
   if (captivePortal()) return; // If captive portal redirect instead of displaying the page
   handleRequest();
-  String page = getHTTPHead(_title); // @token options @todo replace options with title
+  HTTPSendBegin();
+  HTTPSendHead(_title); // @token options @todo replace options with title
   String str  = FPSTR(HTTP_ROOT_MAIN); // @todo custom title
   str.replace(FPSTR(T_t),_title);
   str.replace(FPSTR(T_v),configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())); // use ip if ap is not active for heading @todo use hostname?
-  page += str;
-  page += FPSTR(HTTP_PORTAL_OPTIONS);
-  page += getMenuOut();
-  reportStatus(page);
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  HTTPSendS(str);
+  HTTPSendP(HTTP_PORTAL_OPTIONS);
+  HTTPSendS(getMenuOut());
+  String status;
+  reportStatus(status);
+  HTTPSendS(status);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
   if(_preloadwifiscan) WiFi_scanNetworks(_scancachetime,true); // preload wifiscan throttled, async
   // @todo buggy, captive portals make a query on every page load, causing this to run every time in addition to the real page load
   // I dont understand why, when you are already in the captive portal, I guess they want to know that its still up and not done or gone
@@ -1368,19 +3202,20 @@ void WiFiManager::handleWifi(boolean scan) {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Wifi"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlewifi)); // @token titlewifi
   if (scan) {
     #ifdef WM_DEBUG_LEVEL
-    // DEBUG_WM(DEBUG_DEV,"refresh flag:",server->hasArg(F("refresh")));
+    // DEBUG_WM(DEBUG_DEV,"refresh flag:",_http->hasArg(F("refresh")));
     #endif
-    WiFi_scanNetworks(server->hasArg(F("refresh")),false); //wifiscan, force if arg refresh
-    page += getScanItemOut();
+    WiFi_scanNetworks(_http->hasArg(F("refresh")),false); //wifiscan, force if arg refresh, before headers are sent
   }
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titlewifi)); // @token titlewifi
+  if (scan) HTTPSendS(getScanItemOut());
   String pitem = "";
 
   pitem = FPSTR(HTTP_FORM_START);
   pitem.replace(FPSTR(T_v), F("wifisave")); // set form action
-  page += pitem;
+  HTTPSendS(pitem);
 
   pitem = FPSTR(HTTP_FORM_WIFI);
   pitem.replace(FPSTR(T_v), WiFi_SSID());
@@ -1395,21 +3230,22 @@ void WiFiManager::handleWifi(boolean scan) {
     pitem.replace(FPSTR(T_p),"");    
   }
 
-  page += pitem;
+  HTTPSendS(pitem);
 
-  page += getStaticOut();
-  page += FPSTR(HTTP_FORM_WIFI_END);
+  HTTPSendS(getStaticOut());
+  HTTPSendP(HTTP_FORM_WIFI_END);
   if(_paramsInWifi && _paramsCount>0){
-    page += FPSTR(HTTP_FORM_PARAM_HEAD);
-    page += getParamOut();
+    HTTPSendP(HTTP_FORM_PARAM_HEAD);
+    HTTPSendS(getParamOut());
   }
-  page += FPSTR(HTTP_FORM_END);
-  page += FPSTR(HTTP_SCAN_LINK);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  reportStatus(page);
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  HTTPSendP(HTTP_FORM_END);
+  HTTPSendP(HTTP_SCAN_LINK);
+  if(_showBack) HTTPSendP(HTTP_BACKBTN);
+  String status;
+  reportStatus(status);
+  HTTPSendS(status);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent config page"));
@@ -1424,21 +3260,23 @@ void WiFiManager::handleParam(){
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Param"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleparam)); // @token titlewifi
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleparam)); // @token titlewifi
 
   String pitem = "";
 
   pitem = FPSTR(HTTP_FORM_START);
   pitem.replace(FPSTR(T_v), F("paramsave"));
-  page += pitem;
+  HTTPSendS(pitem);
 
-  page += getParamOut();
-  page += FPSTR(HTTP_FORM_END);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  reportStatus(page);
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  HTTPSendS(getParamOut());
+  HTTPSendP(HTTP_FORM_END);
+  if(_showBack) HTTPSendP(HTTP_BACKBTN);
+  String status;
+  reportStatus(status);
+  HTTPSendS(status);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent param page"));
@@ -1466,8 +3304,23 @@ String WiFiManager::getMenuOut(){
 //   WiFi_scanNetworks(force);
 // }
 
+/**
+ * hand a scan done event result to WiFi_scanComplete, esp32 events arrive in the event task
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::WiFi_scanPoll(){
+  #ifdef ESP32
+  int16_t n = _scanDone;
+  if(n < 0) return;
+  _scanDone = -1;
+  WiFi_scanComplete(n);
+  #endif
+}
+
 void WiFiManager::WiFi_scanComplete(int networksFound){
-  _lastscan = millis();
+  _lastscan = _millis();
+  timerArm(WM_TIMER_SCANCACHE,_scancachetime,_lastscan);
   _numNetworks = networksFound;
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_VERBOSE,F("WiFi Scan ASYNC completed"), "in "+(String)(_lastscan - _startscan)+" ms");  
@@ -1480,12 +3333,13 @@ bool WiFiManager::WiFi_scanNetworks(){
 }
  
 bool WiFiManager::WiFi_scanNetworks(unsigned int cachetime,bool async){
-    return WiFi_scanNetworks(millis()-_lastscan > cachetime,async);
+    return WiFi_scanNetworks(timerElapsed(WM_TIMER_SCANCACHE) > cachetime,async);
 }
 bool WiFiManager::WiFi_scanNetworks(unsigned int cachetime){
-    return WiFi_scanNetworks(millis()-_lastscan > cachetime,false);
+    return WiFi_scanNetworks(timerElapsed(WM_TIMER_SCANCACHE) > cachetime,false);
 }
 bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
+    WiFi_scanPoll();
     #ifdef WM_DEBUG_LEVEL
     // DEBUG_WM(DEBUG_DEV,"scanNetworks async:",async == true);
     // DEBUG_WM(DEBUG_DEV,_numNetworks,(millis()-_lastscan ));
@@ -1500,13 +3354,13 @@ bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
     }
 
     // if scan is empty or stale (last scantime > _scancachetime), this avoids fast reloading wifi page and constant scan delayed page loads appearing to freeze.
-    if(!_lastscan || (_lastscan>0 && (millis()-_lastscan > _scancachetime))){
+    if(timerElapsed(WM_TIMER_SCANCACHE) > _scancachetime){
       force = true;
     }
 
     if(force){
       int8_t res;
-      _startscan = millis();
+      _startscan = _millis();
       if(async && _asyncScan){
         #ifdef ESP8266
           #ifndef WM_NOASYNC // no async available < 2.4.0
@@ -1544,12 +3398,13 @@ bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
           #ifdef WM_DEBUG_LEVEL
           DEBUG_WM(DEBUG_ERROR,".");
           #endif
-          delay(100);
+          _delay(100);
         }
         _numNetworks = WiFi.scanComplete();
       }
       else if(res >=0 ) _numNetworks = res;
-      _lastscan = millis();
+      _lastscan = _millis();
+      timerArm(WM_TIMER_SCANCACHE,_scancachetime,_lastscan);
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_VERBOSE,F("WiFi Scan completed"), "in "+(String)(_lastscan - _startscan)+" ms");
       #endif
@@ -1557,7 +3412,7 @@ bool WiFiManager::WiFi_scanNetworks(bool force,bool async){
     }
     else {
       #ifdef WM_DEBUG_LEVEL
-      DEBUG_WM(DEBUG_VERBOSE,F("Scan is cached"),(String)(millis()-_lastscan )+" ms ago");
+      DEBUG_WM(DEBUG_VERBOSE,F("Scan is cached"),(String)timerElapsed(WM_TIMER_SCANCACHE)+" ms ago");
       #endif
     }
     return false;
@@ -1807,68 +3662,185 @@ void WiFiManager::handleWiFiStatus(){
   // String page = "{\"result\":true,\"count\":1}";
   #ifdef WM_JSTEST
     page = FPSTR(HTTP_JS);
+  #else
+    reportStatus(page); // status fragment, polled for live connecting state during saves
   #endif
   HTTPSend(page);
 }
 
+// fnv-1a over a ram or PROGMEM name, folded to 16 bits for the form index
+static uint16_t formHash(const char *s, bool pgm, size_t &len){
+  uint32_t hash = 2166136261UL;
+  len = 0;
+  for(char c; (c = pgm ? pgm_read_byte(s) : *s); s++, len++) hash = (hash ^ (uint8_t)c) * 16777619UL;
+  return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/**
+ * index the save request args in one pass, name hash to server arg index
+ * the core server already holds the decoded args, this only records where each one is
+ * so lookups are a hash probe instead of a scan and a String copy per name
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::formIndex(){
+  memset(_formSlots, 0xFF, sizeof(_formSlots));
+  _formOverflow = false;
+  uint8_t used = 0;
+  int args = _http->args();
+  for(int i = 0; i < args && i < 0xFF; i++){
+    if(used >= WM_FORM_SLOTS - WM_FORM_SLOTS/4){ // keep probes short, rest is found by scan
+      _formOverflow = true;
+      break;
+    }
+    size_t len;
+    uint16_t hash = formHash(_http->argName(i).c_str(), false, len);
+    uint8_t slot = hash & (WM_FORM_SLOTS - 1);
+    while(_formSlots[slot].arg != 0xFF) slot = (slot + 1) & (WM_FORM_SLOTS - 1);
+    _formSlots[slot] = { hash, (uint8_t)(len < 0xFF ? len : 0xFF), (uint8_t)i }; // long names share 0xFF, strcmp decides
+    used++;
+  }
+  #ifdef WM_DEBUG_LEVEL
+  if(_formOverflow) DEBUG_WM(DEBUG_DEV,F("form index full, args:"),args);
+  #endif
+}
+
+/**
+ * find a save form arg by name in the index
+ * @param  name ram or PROGMEM string
+ * @return server arg index, -1 not found
+ * @since $dev
+ * @access private
+ */
+int WiFiManager::formFind(const char *name, bool pgm){
+  size_t len;
+  uint16_t hash = formHash(name, pgm, len);
+  if(len > 0xFF) len = 0xFF; // clamped like the index
+  uint8_t slot = hash & (WM_FORM_SLOTS - 1);
+  // args are inserted in order, so the first match on the probe chain is the first arg, same as _http->arg(name)
+  for(uint8_t n = 0; n < WM_FORM_SLOTS && _formSlots[slot].arg != 0xFF; n++){
+    const wm_formslot_t &s = _formSlots[slot];
+    if(s.hash == hash && s.len == len){
+      const String &argname = _http->argName(s.arg);
+      if((pgm ? strcmp_P(argname.c_str(), name) : strcmp(argname.c_str(), name)) == 0) return s.arg;
+    }
+    slot = (slot + 1) & (WM_FORM_SLOTS - 1);
+  }
+  if(!_formOverflow) return -1;
+
+  for(int i = WM_FORM_SLOTS - WM_FORM_SLOTS/4; i < _http->args(); i++){
+    const String &argname = _http->argName(i);
+    if((pgm ? strcmp_P(argname.c_str(), name) : strcmp(argname.c_str(), name)) == 0) return i;
+  }
+  return -1;
+}
+
+int WiFiManager::formArg(PGM_P name){
+  return formFind(name, true);
+}
+
+/**
+ * find the save form arg for a custom parameter, param_<i> from custom html first, else the param id
+ * @since $dev
+ * @access private
+ */
+int WiFiManager::formParam(int i){
+  char name[16];
+  strncpy_P(name, S_parampre, sizeof(name) - 1);
+  name[sizeof(name) - 1] = '\0';
+  size_t len = strlen(name);
+  snprintf(name + len, sizeof(name) - len, "%d", i); // truncates, a custom prefix too long just finds no arg
+  int arg = formFind(name, false);
+  if(arg < 0 && _params[i]->getID()) arg = formFind(_params[i]->getID(), false);
+  return arg;
+}
+
 /** 
  * HTTPD CALLBACK save form and redirect to WLAN config page again
  */
 void WiFiManager::handleWifiSave() {
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP WiFi save "));
-  DEBUG_WM(DEBUG_DEV,F("Method:"),server->method() == HTTP_GET  ? (String)FPSTR(S_GET) : (String)FPSTR(S_POST));
+  DEBUG_WM(DEBUG_DEV,F("Method:"),_http->method() == HTTP_GET  ? (String)FPSTR(S_GET) : (String)FPSTR(S_POST));
   #endif
   handleRequest();
 
   //SAVE/connect here
-  _ssid = server->arg(F("s")).c_str();
-  _pass = server->arg(F("p")).c_str();
+  formIndex();
+  int arg = formArg(PSTR("s"));
+  _ssid = arg < 0 ? String() : _http->arg(arg);
+  arg = formArg(PSTR("p"));
+  _pass = arg < 0 ? String() : _http->arg(arg);
 
   #ifdef WM_DEBUG_LEVEL
   String requestinfo = "SERVER_REQUEST\n----------------\n";
   requestinfo += "URI: ";
-  requestinfo += server->uri();
+  requestinfo += _http->uri();
   requestinfo += "\nMethod: ";
-  requestinfo += (server->method() == HTTP_GET) ? "GET" : "POST";
+  requestinfo += (_http->method() == HTTP_GET) ? "GET" : "POST";
   requestinfo += "\nArguments: ";
-  requestinfo += server->args();
+  requestinfo += _http->args();
   requestinfo += "\n";
-  for (uint8_t i = 0; i < server->args(); i++) {
-    requestinfo += " " + server->argName(i) + ": " + server->arg(i) + "\n";
+  for (uint8_t i = 0; i < _http->args(); i++) {
+    requestinfo += " " + _http->argName(i) + ": " + _http->arg(i) + "\n";
   }
 
   DEBUG_WM(DEBUG_MAX,requestinfo);
   #endif
 
-  // set static ips from server args
-  if (server->arg(FPSTR(S_ip)) != "") {
-    //_sta_static_ip.fromString(server->arg(FPSTR(S_ip));
-    String ip = server->arg(FPSTR(S_ip));
-    optionalIPFromString(&_sta_static_ip, ip.c_str());
+  // fail fast on creds that cannot work, before any callbacks or connect
+  wm_savecheck_t check = _saveValidation ? checkWifiSave(_ssid,_pass) : SAVECHECK_OK;
+  _saveNotFound = (check == SAVECHECK_NOTFOUND);
+  if(check == SAVECHECK_NOPASS || check == SAVECHECK_BADPASS){
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_ERROR,F("[ERROR] wifi save rejected, password invalid for:"),_ssid);
+    #endif
+    if(_paramsInWifi) doParamSave(); // params on the same form are kept, only the creds are rejected
+    HTTPSendBegin();
+    HTTPSendHead(FPSTR(S_titlewifi)); // @token titlewifi
+    String msg = FPSTR(HTTP_SAVEREJECT);
+    msg.replace(FPSTR(T_r),check == SAVECHECK_NOPASS ? FPSTR(S_savenopass) : FPSTR(S_savebadpass));
+    msg.replace(FPSTR(T_v),htmlEntities(_ssid));
+    HTTPSendS(msg);
+    if(_showBack) HTTPSendP(HTTP_BACKBTN);
+    HTTPSendP(HTTP_END);
+    HTTPSendEnd();
+    _ssid = "";
+    _pass = "";
+    return;
+  }
+
+  // set static ips from server args, each value is fetched once
+  arg = formArg(S_ip);
+  if (arg >= 0) {
+    const String &value = _http->arg(arg);
+    if(value.length() > 0) optionalIPFromString(&_sta_static_ip, value.c_str());
     #ifdef WM_DEBUG_LEVEL
-    DEBUG_WM(DEBUG_DEV,F("static ip:"),ip);
+    if(value.length() > 0) DEBUG_WM(DEBUG_DEV,F("static ip:"),value);
     #endif
   }
-  if (server->arg(FPSTR(S_gw)) != "") {
-    String gw = server->arg(FPSTR(S_gw));
-    optionalIPFromString(&_sta_static_gw, gw.c_str());
+  arg = formArg(S_gw);
+  if (arg >= 0) {
+    const String &value = _http->arg(arg);
+    if(value.length() > 0) optionalIPFromString(&_sta_static_gw, value.c_str());
     #ifdef WM_DEBUG_LEVEL
-    DEBUG_WM(DEBUG_DEV,F("static gateway:"),gw);
+    if(value.length() > 0) DEBUG_WM(DEBUG_DEV,F("static gateway:"),value);
     #endif
   }
-  if (server->arg(FPSTR(S_sn)) != "") {
-    String sn = server->arg(FPSTR(S_sn));
-    optionalIPFromString(&_sta_static_sn, sn.c_str());
+  arg = formArg(S_sn);
+  if (arg >= 0) {
+    const String &value = _http->arg(arg);
+    if(value.length() > 0) optionalIPFromString(&_sta_static_sn, value.c_str());
     #ifdef WM_DEBUG_LEVEL
-    DEBUG_WM(DEBUG_DEV,F("static netmask:"),sn);
+    if(value.length() > 0) DEBUG_WM(DEBUG_DEV,F("static netmask:"),value);
     #endif
   }
-  if (server->arg(FPSTR(S_dns)) != "") {
-    String dns = server->arg(FPSTR(S_dns));
-    optionalIPFromString(&_sta_static_dns, dns.c_str());
+  arg = formArg(S_dns);
+  if (arg >= 0) {
+    const String &value = _http->arg(arg);
+    if(value.length() > 0) optionalIPFromString(&_sta_static_dns, value.c_str());
     #ifdef WM_DEBUG_LEVEL
-    DEBUG_WM(DEBUG_DEV,F("static DNS:"),dns);
+    if(value.length() > 0) DEBUG_WM(DEBUG_DEV,F("static DNS:"),value);
     #endif
   }
 
@@ -1878,27 +3850,33 @@ void WiFiManager::handleWifiSave() {
 
   if(_paramsInWifi) doParamSave();
 
-  String page;
+  _http->sendHeader(FPSTR(HTTP_HEAD_CORS), FPSTR(HTTP_HEAD_CORS_ALLOW_ALL)); // @HTTPHEAD send cors
+  HTTPSendBegin();
 
   if(_ssid == ""){
-    page = getHTTPHead(FPSTR(S_titlewifisettings)); // @token titleparamsaved
-    page += FPSTR(HTTP_PARAMSAVED);
+    HTTPSendHead(FPSTR(S_titlewifisettings)); // @token titleparamsaved
+    HTTPSendP(HTTP_PARAMSAVED);
   }
   else {
-    page = getHTTPHead(FPSTR(S_titlewifisaved)); // @token titlewifisaved
-    page += FPSTR(HTTP_SAVED);
+    HTTPSendHead(FPSTR(S_titlewifisaved)); // @token titlewifisaved
+    HTTPSendP(HTTP_SAVED);
+    if(check == SAVECHECK_NOTFOUND || check == SAVECHECK_OPENPASS){
+      String msg = FPSTR(HTTP_SAVEWARN);
+      msg.replace(FPSTR(T_r),check == SAVECHECK_NOTFOUND ? FPSTR(S_savenotfound) : FPSTR(S_saveopenpass));
+      msg.replace(FPSTR(T_v),htmlEntities(_ssid));
+      HTTPSendS(msg);
+    }
   }
 
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  page += FPSTR(HTTP_END);
-
-  server->sendHeader(FPSTR(HTTP_HEAD_CORS), FPSTR(HTTP_HEAD_CORS_ALLOW_ALL)); // @HTTPHEAD send cors
-  HTTPSend(page);
+  if(_showBack) HTTPSendP(HTTP_BACKBTN);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent wifi save page"));
   #endif
 
+  postPortalEvent(WM_EVT_SAVED);
   connect = true; //signal ready to connect/reset process in processConfigPortal
 }
 
@@ -1908,18 +3886,19 @@ void WiFiManager::handleParamSave() {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Param save "));
   #endif
   #ifdef WM_DEBUG_LEVEL
-  DEBUG_WM(DEBUG_DEV,F("Method:"),server->method() == HTTP_GET  ? (String)FPSTR(S_GET) : (String)FPSTR(S_POST));
+  DEBUG_WM(DEBUG_DEV,F("Method:"),_http->method() == HTTP_GET  ? (String)FPSTR(S_GET) : (String)FPSTR(S_POST));
   #endif
   handleRequest();
 
+  formIndex();
   doParamSave();
 
-  String page = getHTTPHead(FPSTR(S_titleparamsaved)); // @token titleparamsaved
-  page += FPSTR(HTTP_PARAMSAVED);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN); 
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleparamsaved)); // @token titleparamsaved
+  HTTPSendP(HTTP_PARAMSAVED);
+  if(_showBack) HTTPSendP(HTTP_BACKBTN); 
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent param save page"));
@@ -1946,19 +3925,15 @@ void WiFiManager::doParamSave(){
         #endif
         break; // @todo might not be needed anymore
       }
-      //read parameter from server
-      String name = (String)FPSTR(S_parampre)+(String)i;
-      String value;
-      if(server->hasArg(name)) {
-        value = server->arg(name);
-      } else {
-        value = server->arg(_params[i]->getID());
+      //read parameter from server, param_<i> or id, missing args store empty
+      int arg = formParam(i);
+      if(arg < 0) _params[i]->_value[0] = '\0';
+      else {
+        strncpy(_params[i]->_value, _http->arg(arg).c_str(), _params[i]->_length);
+        _params[i]->_value[_params[i]->_length] = '\0'; // length+1 null terminated
       }
-
-      //store it in params array
-      value.toCharArray(_params[i]->_value, _params[i]->_length+1); // length+1 null terminated
       #ifdef WM_DEBUG_LEVEL
-      DEBUG_WM(DEBUG_VERBOSE,(String)_params[i]->getID() + ":",value);
+      DEBUG_WM(DEBUG_VERBOSE,(String)_params[i]->getID() + ":",_params[i]->_value);
       #endif
     }
     #ifdef WM_DEBUG_LEVEL
@@ -1969,6 +3944,7 @@ void WiFiManager::doParamSave(){
    if ( _saveparamscallback != NULL) {
     _saveparamscallback();  // @CALLBACK
   }
+  postPortalEvent(WM_EVT_PARAMSSAVED);
    
 }
 
@@ -1980,15 +3956,18 @@ void WiFiManager::handleInfo() {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Info"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleinfo)); // @token titleinfo
-  reportStatus(page);
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleinfo)); // @token titleinfo
+  String status;
+  reportStatus(status);
+  HTTPSendS(status);
 
   uint16_t infos = 0;
 
   //@todo convert to enum or refactor to strings
   //@todo wrap in build flag to remove all info code for memory saving
   #ifdef ESP8266
-    infos = 28;
+    infos = 30;
     String infoids[] = {
       F("esphead"),
       F("uptime"),
@@ -2005,6 +3984,8 @@ void WiFiManager::handleInfo() {
       F("lastreset"),
       F("wifihead"),
       F("conx"),
+      F("conxtime"),
+      F("conxstats"),
       F("stassid"),
       F("staip"),
       F("stagw"),
@@ -2022,7 +4003,7 @@ void WiFiManager::handleInfo() {
 
   #elif defined(ESP32)
     // add esp_chip_info ?
-    infos = 27;
+    infos = 29;
     String infoids[] = {
       F("esphead"),
       F("uptime"),
@@ -2039,6 +4020,8 @@ void WiFiManager::handleInfo() {
       // F("hall"),
       F("wifihead"),
       F("conx"),
+      F("conxtime"),
+      F("conxstats"),
       F("stassid"),
       F("staip"),
       F("stagw"),
@@ -2056,27 +4039,26 @@ void WiFiManager::handleInfo() {
   #endif
 
   for(size_t i=0; i<infos;i++){
-    if(infoids[i] != NULL) page += getInfoData(infoids[i]);
+    if(infoids[i] != NULL) HTTPSendS(getInfoData(infoids[i]));
   }
-  page += F("</dl>");
+  HTTPSendS(F("</dl>"));
 
-  page += F("<h3>About</h3><hr><dl>");
-  page += getInfoData("aboutver");
-  page += getInfoData("aboutarduinover");
-  page += getInfoData("aboutidfver");
-  page += getInfoData("aboutdate");
-  page += F("</dl>");
+  HTTPSendS(F("<h3>About</h3><hr><dl>"));
+  HTTPSendS(getInfoData("aboutver"));
+  HTTPSendS(getInfoData("aboutarduinover"));
+  HTTPSendS(getInfoData("aboutidfver"));
+  HTTPSendS(getInfoData("aboutdate"));
+  HTTPSendS(F("</dl>"));
 
   if(_showInfoUpdate){
-    page += HTTP_PORTAL_MENU[8];
-    page += HTTP_PORTAL_MENU[9];
+    HTTPSendS(HTTP_PORTAL_MENU[8]);
+    HTTPSendS(HTTP_PORTAL_MENU[9]);
   }
-  if(_showInfoErase) page += FPSTR(HTTP_ERASEBTN);
-  if(_showBack) page += FPSTR(HTTP_BACKBTN);
-  page += FPSTR(HTTP_HELP);
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  if(_showInfoErase) HTTPSendP(HTTP_ERASEBTN);
+  if(_showBack) HTTPSendP(HTTP_BACKBTN);
+  HTTPSendP(HTTP_HELP);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(DEBUG_DEV,F("Sent info page"));
@@ -2099,8 +4081,8 @@ String WiFiManager::getInfoData(String id){
   else if(id==F("uptime")){
     // subject to rollover!
     p = FPSTR(HTTP_INFO_uptime);
-    p.replace(FPSTR(T_1),(String)(millis() / 1000 / 60));
-    p.replace(FPSTR(T_2),(String)((millis() / 1000) % 60));
+    p.replace(FPSTR(T_1),(String)(_millis() / 1000 / 60));
+    p.replace(FPSTR(T_2),(String)((_millis() / 1000) % 60));
   }
   else if(id==F("chipid")){
     p = FPSTR(HTTP_INFO_chipid);
@@ -2267,6 +4249,38 @@ String WiFiManager::getInfoData(String id){
     p = FPSTR(HTTP_INFO_conx);
     p.replace(FPSTR(T_1),WiFi.isConnected() ? FPSTR(S_y) : FPSTR(S_n));
   }
+  else if(id==F("conxtime")){
+    // most recent first
+    for(uint8_t i=0; i<_conntimingCount; i++){
+      wm_conntiming_t t = getConnectTiming(i);
+      String row = FPSTR(HTTP_INFO_conxtime);
+      row.replace(FPSTR(T_1),(String)t.connected);
+      row.replace(FPSTR(T_2),(String)t.gotip);
+      row.replace(FPSTR(T_3),(String)t.total);
+      String res = getWLStatusString(t.status);
+      if(t.reason) res += " (" + (String)t.reason + ")";
+      row.replace(FPSTR(T_r),res);
+      p += row;
+    }
+  }
+  else if(id==F("conxstats")){
+    wm_connstats_t stats = getConnectStats();
+    uint32_t total = 0;
+    for(uint8_t i=0; i<9; i++) total += stats.status[i];
+    p = FPSTR(HTTP_INFO_conxstats);
+    p.replace(FPSTR(T_1),(String)stats.status[WL_CONNECTED]);
+    p.replace(FPSTR(T_2),(String)(total - stats.status[WL_CONNECTED]));
+    // failure reasons, slot mapping see wm_connstats_t
+    String reasons;
+    for(uint8_t i=1; i<36; i++){
+      if(!stats.reason[i]) continue;
+      if(reasons != "") reasons += ", ";
+      if(i == 25) reasons += FPSTR(S_NA);
+      else reasons += (String)(i < 25 ? i : 200 + (i - 26));
+      reasons += ":" + (String)stats.reason[i];
+    }
+    p.replace(FPSTR(T_r),reasons);
+  }
   #ifdef ESP8266
   else if(id==F("autoconx")){
     p = FPSTR(HTTP_INFO_autoconx);
@@ -2326,11 +4340,12 @@ void WiFiManager::handleExit() {
   #endif
   _WifiAP_active = false;
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleexit)); // @token titleexit
-  page += FPSTR(S_exiting); // @token exiting
   // ('Logout', 401, {'WWW-Authenticate': 'Basic realm="Login required"'})
-  server->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
-  HTTPSend(page);
+  _http->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleexit)); // @token titleexit
+  HTTPSendP(S_exiting); // @token exiting
+  HTTPSendEnd();
   delay(2000);
   abort = true;
 }
@@ -2343,11 +4358,11 @@ void WiFiManager::handleReset() {
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP Reset"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titlereset)); //@token titlereset
-  page += FPSTR(S_resetting); //@token resetting
-  page += FPSTR(HTTP_END);
-
-  HTTPSend(page);
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titlereset)); //@token titlereset
+  HTTPSendP(S_resetting); //@token resetting
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   #ifdef WM_DEBUG_LEVEL
   DEBUG_WM(F("RESETTING ESP"));
@@ -2368,20 +4383,20 @@ void WiFiManager::handleErase(boolean opt) {
   DEBUG_WM(DEBUG_NOTIFY,F("<- HTTP Erase"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleerase)); // @token titleerase
-
   bool ret = erase(opt);
 
-  if(ret) page += FPSTR(S_resetting); // @token resetting
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleerase)); // @token titleerase
+  if(ret) HTTPSendP(S_resetting); // @token resetting
   else {
-    page += FPSTR(S_error); // @token erroroccur
+    HTTPSendP(S_error); // @token erroroccur
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM(DEBUG_ERROR,F("[ERROR] WiFi EraseConfig failed"));
     #endif
   }
 
-  page += FPSTR(HTTP_END);
-  HTTPSend(page);
+  HTTPSendP(HTTP_END);
+  HTTPSendEnd();
 
   if(ret){
     delay(2000);
@@ -2400,20 +4415,20 @@ void WiFiManager::handleNotFound() {
   handleRequest();
   String message = FPSTR(S_notfound); // @token notfound
   message += FPSTR(S_uri); // @token uri
-  message += server->uri();
+  message += _http->uri();
   message += FPSTR(S_method); // @token method
-  message += ( server->method() == HTTP_GET ) ? FPSTR(S_GET) : FPSTR(S_POST);
+  message += ( _http->method() == HTTP_GET ) ? FPSTR(S_GET) : FPSTR(S_POST);
   message += FPSTR(S_args); // @token args
-  message += server->args();
+  message += _http->args();
   message += F("\n");
 
-  for ( uint8_t i = 0; i < server->args(); i++ ) {
-    message += " " + server->argName ( i ) + ": " + server->arg ( i ) + "\n";
+  for ( uint8_t i = 0; i < _http->args(); i++ ) {
+    message += " " + _http->argName ( i ) + ": " + _http->arg ( i ) + "\n";
   }
-  server->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
-  server->sendHeader(F("Pragma"), F("no-cache"));
-  server->sendHeader(F("Expires"), F("-1"));
-  server->send ( 404, FPSTR(HTTP_HEAD_CT2), message );
+  _http->sendHeader(F("Cache-Control"), F("no-cache, no-store, must-revalidate")); // @HTTPHEAD send cache
+  _http->sendHeader(F("Pragma"), F("no-cache"));
+  _http->sendHeader(F("Expires"), F("-1"));
+  _http->send ( 404, FPSTR(HTTP_HEAD_CT2), message );
 }
 
 /**
@@ -2423,28 +4438,51 @@ void WiFiManager::handleNotFound() {
  */
 boolean WiFiManager::captivePortal() {
   #ifdef WM_DEBUG_LEVEL
-  DEBUG_WM(DEBUG_MAX,"-> " + server->hostHeader());
+  DEBUG_WM(DEBUG_MAX,F("->"),_http->hostHeader());
   #endif
   
   if(!_enableCaptivePortal) return false; // skip redirections, @todo maybe allow redirection even when no cp ? might be useful
+  #ifndef WM_ASYNCWEBSERVER
+  if(_appServer) return false; // mounted on an app server, its host and port are the app's
+  #endif
   
-  String serverLoc =  toStringIp(server->client().localIP());
-  if(_httpPort != 80) serverLoc += ":" + (String)_httpPort; // add port if not default
-  bool doredirect = serverLoc != server->hostHeader(); // redirect if hostheader not server ip, prevent redirect loops
-  // doredirect = !isIp(server->hostHeader()) // old check
+  // request came in on another interface or the ip changed, rare, rebuild for it
+  IPAddress local = _http->localIP();
+  if((uint32_t)local != (uint32_t)_cpIP) buildCaptiveRedirect(local);
+
+  const String &host = _http->hostHeader();
+  bool doredirect = !(host.length() == _cpHostLen && memcmp(host.c_str(), _cpHost, _cpHostLen) == 0); // redirect if hostheader not server ip, prevent redirect loops
+  // doredirect = !isIp(_http->hostHeader()) // old check
   
-  if (doredirect) {
+  if (doredirect && _cpRedirectLen > 0) {
     #ifdef WM_DEBUG_LEVEL
     DEBUG_WM(DEBUG_VERBOSE,F("<- Request redirected to captive portal"));
     #endif
-    server->sendHeader(F("Location"), (String)F("http://") + serverLoc, true); // @HTTPHEAD send redirect
-    server->send ( 302, FPSTR(HTTP_HEAD_CT2), ""); // Empty content inhibits Content-length header so we have to close the socket ourselves.
-    server->client().stop(); // Stop is needed because we sent no content length
+    // @HTTPHEAD send redirect, prebuilt status, location and headers in one write
+    _http->sendRaw((const uint8_t*)_cpRedirect, _cpRedirectLen);
     return true;
   }
   return false;
 }
 
+/**
+ * build the captive redirect host and 302 response for the portal ip, once per ip
+ * @param  ip portal ip, softap ip for the config portal
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::buildCaptiveRedirect(IPAddress ip){
+  _cpIP = ip;
+  int len = snprintf(_cpHost, sizeof(_cpHost), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  if(_httpPort != 80) len += snprintf(_cpHost + len, sizeof(_cpHost) - len, ":%u", _httpPort); // add port if not default
+  _cpHostLen = len;
+  len = snprintf_P(_cpRedirect, sizeof(_cpRedirect), HTTP_CP_REDIRECT, _cpHost);
+  _cpRedirectLen = (len > 0 && len < (int)sizeof(_cpRedirect)) ? len : 0;
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_DEV,F("captive redirect to:"),_cpHost);
+  #endif
+}
+
 void WiFiManager::stopCaptivePortal(){
   _enableCaptivePortal= false;
   // @todo maybe disable configportaltimeout(optional), or just provide callback for user
@@ -2459,9 +4497,10 @@ void WiFiManager::handleClose(){
   DEBUG_WM(DEBUG_VERBOSE,F("<- HTTP close"));
   #endif
   handleRequest();
-  String page = getHTTPHead(FPSTR(S_titleclose)); // @token titleclose
-  page += FPSTR(S_closing); // @token closing
-  HTTPSend(page);
+  HTTPSendBegin();
+  HTTPSendHead(FPSTR(S_titleclose)); // @token titleclose
+  HTTPSendP(S_closing); // @token closing
+  HTTPSendEnd();
 }
 
 void WiFiManager::reportStatus(String &page){
@@ -2469,7 +4508,12 @@ void WiFiManager::reportStatus(String &page){
   DEBUG_WM(DEBUG_DEV,F("[WIFI] reportStatus prev:"),getWLStatusString(_lastconxresult));
   DEBUG_WM(DEBUG_DEV,F("[WIFI] reportStatus current:"),getWLStatusString(WiFi.status()));
   String str;
-  if (WiFi_SSID() != ""){
+  if (_saveState != SAVE_IDLE && _ssid != ""){
+    // save in progress, show live connecting status
+    str = FPSTR(HTTP_STATUS_CONN);
+    str.replace(FPSTR(T_v),htmlEntities(_ssid));
+  }
+  else if (WiFi_SSID() != ""){
     if (WiFi.status()==WL_CONNECTED){
       str = FPSTR(HTTP_STATUS_ON);
       str.replace(FPSTR(T_i),WiFi.localIP().toString());
@@ -2518,6 +4562,9 @@ void WiFiManager::reportStatus(String &page){
  * @return {[type]} [description]
  */
 bool WiFiManager::stopConfigPortal(){
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
   if(_configPortalIsBlocking){
     abort = true;
     return true;
@@ -2678,6 +4725,105 @@ void WiFiManager::setConnectRetries(uint8_t numRetries){
   _connectRetries = constrain(numRetries,1,10);
 }
 
+/**
+ * setFastAutoConnect, let autoConnect reuse an sta the sdk already (re)connected at boot
+ * disable to always restart sta, eg. to force static ip or hostname changes
+ * @since $dev
+ * @access public
+ * @param bool enable, default true
+ */
+void WiFiManager::setFastAutoConnect(bool enable){
+  _fastAutoConnect = enable;
+}
+
+/**
+ * setReconnectBackoff, enable the non blocking reconnect scheduler
+ * reconnects are driven from process() with exponential backoff and jitter instead of esp autoreconnect
+ * wrong password stops retrying, ap not found backs off slower, assoc fail retries fast
+ * @since $dev
+ * @access public
+ * @param bool enable
+ * @param unsigned long minms first retry interval in ms
+ * @param unsigned long maxms interval cap in ms
+ */
+void WiFiManager::setReconnectBackoff(bool enable, unsigned long minms, unsigned long maxms){
+  _reconnBackoff = enable;
+  _reconnMin     = minms > 0 ? minms : 1;
+  _reconnMax     = maxms > _reconnMin ? maxms : _reconnMin;
+  _reconnDelay   = 0;
+  _reconnHalted  = false;
+}
+
+/**
+ * setSaveValidation, check wifi saves against the last scan before connecting
+ * empty or invalid length passwords for secured networks are rejected on the save page
+ * ssids missing from the scan are flagged and end the connect on the first ap not found
+ * @since $dev
+ * @access public
+ * @param bool enable
+ */
+void WiFiManager::setSaveValidation(bool enable){
+  _saveValidation = enable;
+}
+
+/**
+ * setPortalEvents, queue portal events for the app to drain with getPortalEvent
+ * nothing is allocated or called inline, slow app code cannot stall the portal
+ * callbacks keep working, leave them unset to only use events
+ * @since $dev
+ * @access public
+ * @param bool enable
+ */
+void WiFiManager::setPortalEvents(bool enable){
+  _portalEvents = enable;
+}
+
+/**
+ * setConfigPortalIdleSleep, sleep in the blocking portal loop while idle
+ * idle is no stations associated, no page requests for 2s and no save in progress
+ * softap keeps the radio on, savings come from the cpu idling in delay instead of a hot spin
+ * @since $dev
+ * @access public
+ * @param uint16_t ms sleep per idle pass, worst case wake latency, 0 disables (default)
+ */
+void WiFiManager::setConfigPortalIdleSleep(uint16_t ms){
+  _cpIdleSleep = ms;
+}
+
+/**
+ * get blocking portal loop cpu duty cycle
+ * @since $dev
+ * @access public
+ * @return uint8_t percent busy over the last ~10s window, 100 until the first window completes
+ */
+uint8_t WiFiManager::getConfigPortalDutyCycle(){
+  return _cpDutyCycle;
+}
+
+/**
+ * get time until the earliest pending deadline
+ * covers portal timeout, save and connect waits, reconnect backoff and scan cache expiry
+ * @since $dev
+ * @access public
+ * @return unsigned long ms, 0 if something is due now, ULONG_MAX if nothing is pending
+ */
+unsigned long WiFiManager::getNextDeadline(){
+  if(_timerNext < 0) return ULONG_MAX;
+  return timerRemaining((wm_timer_t)_timerNext);
+}
+
+/**
+ * setProcessBudget, limit time spent in one process() call
+ * dns is served every call, at least one other task runs, the rest resume on the next call
+ * a single slow handler cannot be preempted, see getTaskMaxTime
+ * @since $dev
+ * @access public
+ * @param unsigned long ms, 0 runs every task each call (default)
+ */
+void WiFiManager::setProcessBudget(unsigned long ms){
+  _processBudget = ms;
+}
+
 /**
  * toggle _cleanconnect, always disconnect before connecting
  * @param {[type]} bool enable [description]
@@ -2796,6 +4942,7 @@ void WiFiManager::setAPCallback( std::function<void(WiFiManager*)> func ) {
  */
 void WiFiManager::setWebServerCallback( std::function<void()> func ) {
   _webservercallback = func;
+  _httpServerStale   = true; // a kept server is recreated so the callback runs
 }
 
 /**
@@ -2862,6 +5009,34 @@ void WiFiManager::setConfigPortalTimeoutCallback( std::function<void()> func ) {
   _configportaltimeoutcallback = func;
 }
 
+/**
+ * setClock, replace the time source for timeouts, waits and duration stats
+ * a virtual clock lets timeouts run in ms and can start near rollover, eg. 0xFFFF0000
+ * without delayfunc, waits add the ms waited on top of millisfunc so blocking waits still time out
+ * @since $dev
+ * @access public
+ * @param {[type]} unsigned long (*millisfunc)(void), NULL uses millis()
+ * @param {[type]} void (*delayfunc)(unsigned long), NULL uses delay(), or the virtual clock with millisfunc
+ */
+void WiFiManager::setClock( std::function<unsigned long()> millisfunc, std::function<void(unsigned long)> delayfunc ) {
+  _millisfunc  = millisfunc;
+  _delayfunc   = delayfunc;
+  _clockWaited = 0;
+}
+
+/**
+ * setWiFiSim, replace the radio status and begin used by connect, save and reconnect
+ * with setClock a test drives timeout, retry and reconnect paths in ms without an ap
+ * @since $dev
+ * @access public
+ * @param {[type]} uint8_t (*statusfunc)(void) wl_status_t, NULL uses WiFi.status()
+ * @param {[type]} bool (*beginfunc)(const char *ssid, const char *pass) NULL uses WiFi.begin()
+ */
+void WiFiManager::setWiFiSim( std::function<uint8_t()> statusfunc, std::function<bool(const char*,const char*)> beginfunc ) {
+  _statusfunc = statusfunc;
+  _beginfunc  = beginfunc;
+}
+
 /**
  * set custom head html
  * custom element will be added to head, eg. new meta,style,script tag etc.
@@ -3086,132 +5261,348 @@ void WiFiManager::setShowInfoErase(boolean enabled){
  * toggle showing update upload web ota button on info page
  * @param boolean enabled
  */
-void WiFiManager::setShowInfoUpdate(boolean enabled){
-  _showInfoUpdate = enabled;
+void WiFiManager::setShowInfoUpdate(boolean enabled){
+  _showInfoUpdate = enabled;
+}
+
+/**
+ * check if the config portal is running
+ * @return bool true if active
+ */
+bool WiFiManager::getConfigPortalActive(){
+  return configPortalActive;
+}
+
+/**
+ * [getConfigPortalActive description]
+ * @return bool true if active
+ */
+bool WiFiManager::getWebPortalActive(){
+  return webPortalActive;
+}
+
+
+String WiFiManager::getWiFiHostname(){
+  #ifdef ESP32
+    return (String)WiFi.getHostname();
+  #else
+    return (String)WiFi.hostname();
+  #endif
+}
+
+/**
+ * [setTitle description]
+ * @param String title, set app title
+ */
+void WiFiManager::setTitle(String title){
+  _title = title;
+}
+
+/**
+ * set menu items and order
+ * if param is present in menu , params will be removed from wifi page automatically
+ * eg.
+ *  const char * menu[] = {"wifi","setup","sep","info","exit"};
+ *  WiFiManager.setMenu(menu);
+ * @since $dev
+ * @param uint8_t menu[] array of menu ids
+ */
+void WiFiManager::setMenu(const char * menu[], uint8_t size){
+#ifdef WM_DEBUG_LEVEL
+  // DEBUG_WM(DEBUG_DEV,"setmenu array");
+  #endif
+  _menuIds.clear();
+  for(size_t i = 0; i < size; i++){
+    for(size_t j = 0; j < _nummenutokens; j++){
+      if(menu[i] == _menutokens[j]){
+        if((String)menu[i] == "param") _paramsInWifi = false; // param auto flag
+        _menuIds.push_back(j);
+      }
+    }
+  }
+  #ifdef WM_DEBUG_LEVEL
+  // DEBUG_WM(getMenuOut());
+  #endif
+}
+
+/**
+ * setMenu with vector
+ * eg.
+ * std::vector<const char *> menu = {"wifi","setup","sep","info","exit"};
+ * WiFiManager.setMenu(menu);
+ * tokens can be found in _menutokens array in strings_en.h
+ * @shiftIncrement $dev
+ * @param {[type]} std::vector<const char *>& menu [description]
+ */
+void WiFiManager::setMenu(std::vector<const char *>& menu){
+#ifdef WM_DEBUG_LEVEL
+  // DEBUG_WM(DEBUG_DEV,"setmenu vector");
+  #endif
+  _menuIds.clear();
+  for(auto menuitem : menu ){
+    for(size_t j = 0; j < _nummenutokens; j++){
+      if(menuitem == _menutokens[j]){
+        if((String)menuitem == "param") _paramsInWifi = false; // param auto flag
+        _menuIds.push_back(j);
+      }
+    }
+  }
+  #ifdef WM_DEBUG_LEVEL
+  // DEBUG_WM(DEBUG_DEV,getMenuOut());
+  #endif
+}
+
+
+/**
+ * set params as sperate page not in wifi
+ * NOT COMPATIBLE WITH setMenu! 
+ * @todo scan menuids and insert param after wifi or something, same for ota
+ * @param bool enable 
+ * @since $dev
+ */
+void WiFiManager::setParamsPage(bool enable){
+  _paramsInWifi  = !enable;
+  setMenu(enable ? _menuIdsParams : _menuIdsDefault);
+}
+
+// GETTERS
+
+/**
+ * get config portal AP SSID
+ * @since 0.0.1
+ * @access public
+ * @return String the configportal ap name
+ */
+String WiFiManager::getConfigPortalSSID() {
+  return _apName;
+}
+
+/**
+ * return the last known connection result
+ * logged on autoconnect and wifisave, can be used to check why failed
+ * get as readable string with getWLStatusString(getLastConxResult);
+ * @since $dev
+ * @access public
+ * @return bool return wl_status codes
+ */
+uint8_t WiFiManager::getLastConxResult(){
+  return _lastconxresult;
+}
+
+/**
+ * get number of recorded connect timings
+ * @since $dev
+ * @access public
+ * @return uint8_t count, up to WM_CONNTIMING_SIZE
+ */
+uint8_t WiFiManager::getConnectTimingCount(){
+  connTimingPoll();
+  return _conntimingCount;
+}
+
+/**
+ * get connect phase timing for a recent attempt
+ * @since $dev
+ * @access public
+ * @param  uint8_t n attempts back, 0 is most recent
+ * @return wm_conntiming_t, zeroed if n not recorded
+ */
+WiFiManager::wm_conntiming_t WiFiManager::getConnectTiming(uint8_t n){
+  connTimingPoll();
+  if(n >= _conntimingCount) return wm_conntiming_t();
+  return _conntiming[((int)_conntimingHead + WM_CONNTIMING_SIZE - n) % WM_CONNTIMING_SIZE];
+}
+
+/**
+ * get how long the last startAP took until the ap was ready
+ * @since $dev
+ * @access public
+ * @return unsigned long ms
+ */
+unsigned long WiFiManager::getAPStartDuration(){
+  return _apStartDuration;
+}
+
+/**
+ * get how long the last config portal shutdown took, servers, ap and mode restore
+ * @since $dev
+ * @access public
+ * @return unsigned long ms
+ */
+unsigned long WiFiManager::getPortalShutdownDuration(){
+  return _portalShutdownDuration;
+}
+
+/**
+ * get how long the last autoConnect took until connected, excludes any config portal
+ * @since $dev
+ * @access public
+ * @return unsigned long ms, 0 if it did not connect
+ */
+unsigned long WiFiManager::getAutoConnectDuration(){
+  return _autoConnectDuration;
+}
+
+/**
+ * get if the last autoConnect took the fast path, sta was already associated or connecting
+ * @since $dev
+ * @access public
+ * @return bool
+ */
+bool WiFiManager::getAutoConnectFast(){
+  return _autoConnectFast;
+}
+
+/**
+ * queue a portal event, portal context only (loop or portal task)
+ * @since $dev
+ * @access private
+ * @param  wm_event_t evt
+ */
+void WiFiManager::postPortalEvent(wm_event_t evt){
+  if(_portalEvents) _portalEventRing.push(evt);
+}
+
+/**
+ * queue a wifi event, wifi event context only, separate ring keeps both single producer
+ * @since $dev
+ * @access private
+ * @param  wm_event_t evt
+ */
+void WiFiManager::postWiFiEvent(wm_event_t evt){
+  if(_portalEvents) _wifiEventRing.push(evt);
+}
+
+/**
+ * pop the next queued event, portal events first
+ * @since $dev
+ * @access public
+ * @param  wm_event_t evt out
+ * @return bool event available
+ */
+bool WiFiManager::getPortalEvent(wm_event_t &evt){
+  uint8_t e;
+  if(!_portalEventRing.pop(e) && !_wifiEventRing.pop(e)) return false;
+  evt = (wm_event_t)e;
+  return true;
+}
+
+/**
+ * get number of events dropped because the app did not drain
+ * @since $dev
+ * @access public
+ * @return uint16_t
+ */
+uint16_t WiFiManager::getPortalEventsDropped(){
+  return _portalEventRing.dropped() + _wifiEventRing.dropped();
 }
 
 /**
- * check if the config portal is running
- * @return bool true if active
+ * get worst case time of one process() or blocking portal loop pass
+ * @since $dev
+ * @access public
+ * @return unsigned long us
  */
-bool WiFiManager::getConfigPortalActive(){
-  return configPortalActive;
+unsigned long WiFiManager::getProcessMaxLatency(){
+  return _processMaxLatency;
 }
 
 /**
- * [getConfigPortalActive description]
- * @return bool true if active
+ * get worst case time of one task slice
+ * @since $dev
+ * @access public
+ * @param  wm_task_t task
+ * @return unsigned long us
  */
-bool WiFiManager::getWebPortalActive(){
-  return webPortalActive;
+unsigned long WiFiManager::getTaskMaxTime(wm_task_t task){
+  if(task >= WM_TASK_MAX) return 0;
+  return _taskMaxTime[task];
 }
 
-
-String WiFiManager::getWiFiHostname(){
-  #ifdef ESP32
-    return (String)WiFi.getHostname();
-  #else
-    return (String)WiFi.hostname();
-  #endif
+/**
+ * reset process and task worst case times
+ * @since $dev
+ * @access public
+ */
+void WiFiManager::resetProcessStats(){
+  _processMaxLatency = 0;
+  for(uint8_t i = 0; i < WM_TASK_MAX; i++) _taskMaxTime[i] = 0;
+  _httpstats        = {};
+  _httpServiceTotal = 0;
 }
 
 /**
- * [setTitle description]
- * @param String title, set app title
+ * setHTTPPump, serve several queued http clients per process slice
+ * the core webserver holds one client at a time, phones and their os probes queue up behind it
+ * clients are served first come first served in accept order, not round robin, the core has one client slot
+ * a client holds it until its response is done, or until clienttimeout while others are pending
+ * @since $dev
+ * @access public
+ * @param uint8_t maxrequests per http slice, 1 restores one handleClient per slice, default 4
+ * @param unsigned long clienttimeout ms a client may sit on read while others are pending, 0 never drop, default 2000
  */
-void WiFiManager::setTitle(String title){
-  _title = title;
+void WiFiManager::setHTTPPump(uint8_t maxrequests, unsigned long clienttimeout){
+  _httpPumpMax       = maxrequests > 0 ? maxrequests : 1;
+  _httpClientTimeout = clienttimeout;
 }
 
 /**
- * set menu items and order
- * if param is present in menu , params will be removed from wifi page automatically
- * eg.
- *  const char * menu[] = {"wifi","setup","sep","info","exit"};
- *  WiFiManager.setMenu(menu);
+ * setHTTPCompression, gzip portal pages on the fly for clients sending Accept-Encoding gzip
+ * scan lists and param forms are repetitive html, typically 3-5x smaller, saves airtime on busy channels
+ * costs cpu and about 2x WM_DEFLATE_WINDOW + 1k + WM_SENDBUF_SIZE of heap while a page is sent
+ * compare getHTTPStats gzipin, gzipout and gziptime to decide per deployment
+ * set before the portal starts, the request header is collected only when enabled
  * @since $dev
- * @param uint8_t menu[] array of menu ids
+ * @access public
+ * @param bool enable, default false
  */
-void WiFiManager::setMenu(const char * menu[], uint8_t size){
-#ifdef WM_DEBUG_LEVEL
-  // DEBUG_WM(DEBUG_DEV,"setmenu array");
-  #endif
-  _menuIds.clear();
-  for(size_t i = 0; i < size; i++){
-    for(size_t j = 0; j < _nummenutokens; j++){
-      if(menu[i] == _menutokens[j]){
-        if((String)menu[i] == "param") _paramsInWifi = false; // param auto flag
-        _menuIds.push_back(j);
-      }
-    }
-  }
-  #ifdef WM_DEBUG_LEVEL
-  // DEBUG_WM(getMenuOut());
-  #endif
+void WiFiManager::setHTTPCompression(bool enable){
+  if(enable != _httpCompression) _httpServerStale = true; // a kept server is recreated to collect the header
+  _httpCompression = enable;
 }
 
 /**
- * setMenu with vector
- * eg.
- * std::vector<const char *> menu = {"wifi","setup","sep","info","exit"};
- * WiFiManager.setMenu(menu);
- * tokens can be found in _menutokens array in strings_en.h
- * @shiftIncrement $dev
- * @param {[type]} std::vector<const char *>& menu [description]
+ * get http pump stats, use depthmax to size setHTTPPump
+ * @since $dev
+ * @access public
+ * @return wm_httpstats_t
  */
-void WiFiManager::setMenu(std::vector<const char *>& menu){
-#ifdef WM_DEBUG_LEVEL
-  // DEBUG_WM(DEBUG_DEV,"setmenu vector");
-  #endif
-  _menuIds.clear();
-  for(auto menuitem : menu ){
-    for(size_t j = 0; j < _nummenutokens; j++){
-      if(menuitem == _menutokens[j]){
-        if((String)menuitem == "param") _paramsInWifi = false; // param auto flag
-        _menuIds.push_back(j);
-      }
-    }
-  }
-  #ifdef WM_DEBUG_LEVEL
-  // DEBUG_WM(DEBUG_DEV,getMenuOut());
-  #endif
+WiFiManager::wm_httpstats_t WiFiManager::getHTTPStats(){
+  wm_httpstats_t stats = _httpstats;
+  stats.serviceavg = stats.requests ? (unsigned long)(_httpServiceTotal / stats.requests) : 0;
+  return stats;
 }
 
-
 /**
- * set params as sperate page not in wifi
- * NOT COMPATIBLE WITH setMenu! 
- * @todo scan menuids and insert param after wifi or something, same for ota
- * @param bool enable 
+ * get connect outcome counters and duration histograms
  * @since $dev
+ * @access public
+ * @return wm_connstats_t
  */
-void WiFiManager::setParamsPage(bool enable){
-  _paramsInWifi  = !enable;
-  setMenu(enable ? _menuIdsParams : _menuIdsDefault);
+WiFiManager::wm_connstats_t WiFiManager::getConnectStats(){
+  connStatsLoad();
+  return _connstats;
 }
 
-// GETTERS
-
 /**
- * get config portal AP SSID
- * @since 0.0.1
+ * restore connect stats, rtc memory does not survive power loss, ram is not kept over reboots without WM_CONNSTATS_RTC
+ * @since $dev
  * @access public
- * @return String the configportal ap name
+ * @param  wm_connstats_t stats
  */
-String WiFiManager::getConfigPortalSSID() {
-  return _apName;
+void WiFiManager::setConnectStats(const wm_connstats_t &stats){
+  _connstatsLoaded = true;
+  _connstats = stats;
+  connStatsSave();
 }
 
 /**
- * return the last known connection result
- * logged on autoconnect and wifisave, can be used to check why failed
- * get as readable string with getWLStatusString(getLastConxResult);
+ * zero connect stats
  * @since $dev
  * @access public
- * @return bool return wl_status codes
  */
-uint8_t WiFiManager::getLastConxResult(){
-  return _lastconxresult;
+void WiFiManager::resetConnectStats(){
+  setConnectStats(wm_connstats_t());
 }
 
 /**
@@ -3270,6 +5661,28 @@ void WiFiManager::setHttpPort(uint16_t port){
   _httpPort = port;
 }
 
+/**
+ * setWebServerPersistent
+ * keep the webserver object, its routes and _webservercallback handlers when the portal stops
+ * the listener stays open, portal requests get a 503 from process() until the portal starts again, no heap churn or rebind
+ * a blocking startConfigPortal closes the listener when it returns, nothing calls process() then, the next portal reopens it
+ * _webservercallback routes keep being served while stopped and process() is called
+ * _webservercallback runs once, when the server is first created
+ * changing the port, setHTTPCompression or setWebServerCallback recreates it on the next portal start
+ * @since $dev
+ * @param bool enable, default false frees the server on every stop
+ */
+void WiFiManager::setWebServerPersistent(bool enable){
+  #ifdef ESP32
+  WM_PortalLock lock(_portalMutex); // portal task may be mid pass
+  #endif
+  _httpPersistent = enable;
+  if(!enable && !configPortalActive && !webPortalActive){
+    _http.reset(); // free a kept server now
+    server.reset();
+  }
+}
+
 
 bool WiFiManager::preloadWiFi(String ssid, String pass){
   _defaultssid = ssid;
@@ -3723,6 +6136,37 @@ bool WiFiManager::WiFi_hasAutoConnect(){
   return WiFi_SSID(true) != "";
 }
 
+/**
+ * sta connect in flight, eg. sdk autoconnect from stored config at boot
+ * @since $dev
+ * @access private
+ * @return bool
+ */
+bool WiFiManager::WiFi_isConnecting(){
+  #ifdef ESP8266
+    return wifi_station_get_connect_status() == STATION_CONNECTING;
+  #elif defined(ESP32)
+    // no sdk connecting state, an sta event since the handler was installed shows the sdk is trying
+    return _staEventSeen && WiFi_status() != WL_CONNECT_FAILED && WiFi_hasAutoConnect();
+  #endif
+}
+
+/**
+ * attempt ended without a connection, shared by the save and reconnect waits
+ * no ssid only counts once this attempt saw a disconnect, a stale status can be left over from before begin
+ * @since $dev
+ * @access private
+ * @param  uint8_t status wl_status_t
+ * @return bool
+ */
+bool WiFiManager::WiFi_connectFailed(uint8_t status){
+  if(status == WL_CONNECT_FAILED || status == WL_CONNECTION_LOST) return true;
+  #ifdef ESP8266
+  if(status == WL_WRONG_PASSWORD) return true;
+  #endif
+  return status == WL_NO_SSID_AVAIL && _connevtReason != 0;
+}
+
 String WiFiManager::WiFi_SSID(bool persistent) const{
 
     #ifdef ESP8266
@@ -3778,6 +6222,194 @@ String WiFiManager::WiFi_psk(bool persistent) const {
 }
 
 #ifdef ESP32
+/**
+ * run the portal in its own freertos task, keeps page rendering and scans off the app core
+ * process() from the app loop becomes a no-op while the task runs
+ * @since $dev
+ * @access public
+ * @param  BaseType_t core to pin to
+ * @param  uint32_t stackSize bytes
+ * @param  UBaseType_t priority
+ * @return bool started or already running
+ */
+bool WiFiManager::startPortalTask(BaseType_t core, uint32_t stackSize, UBaseType_t priority){
+  if(_portalTask) return true;
+  if(!webPortalActive && !(configPortalActive && !_configPortalIsBlocking)){
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_ERROR,F("[ERROR] portal task needs a web or non blocking config portal"));
+    #endif
+    return false;
+  }
+  if(!_taskCmdQueue) _taskCmdQueue = xQueueCreate(4,sizeof(uint8_t));
+  if(!_taskEvtQueue) _taskEvtQueue = xQueueCreate(8,sizeof(uint8_t));
+  if(!_portalMutex)  _portalMutex  = xSemaphoreCreateRecursiveMutex();
+  if(!_taskCmdQueue || !_taskEvtQueue || !_portalMutex) return false;
+  _portalTaskExit = false;
+
+  portalTaskUpdateStatus();
+  if(xTaskCreatePinnedToCore(portalTask,"wm_portal",stackSize,this,priority,&_portalTask,core) != pdPASS){
+    _portalTask = NULL;
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_ERROR,F("[ERROR] portal task create failed"));
+    #endif
+    return false;
+  }
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_VERBOSE,F("portal task started on core:"),(int)core);
+  #endif
+  return true;
+}
+
+/**
+ * portal task body, runs process() until the portal closes
+ * @since $dev
+ * @access private
+ * @param  void* WiFiManager instance
+ */
+void WiFiManager::portalTask(void *param){
+  WiFiManager *wm = static_cast<WiFiManager*>(param);
+  uint8_t cmd;
+
+  for(;;){
+    xSemaphoreTakeRecursive(wm->_portalMutex,portMAX_DELAY); // app side start/stop wait for the pass
+    while(xQueueReceive(wm->_taskCmdQueue,&cmd,0) == pdTRUE){
+      if(cmd == WM_TASKCMD_STOP){
+        if(wm->webPortalActive) wm->stopWebPortal();
+        else if(wm->configPortalActive) wm->stopConfigPortal();
+      }
+      else if(cmd == WM_TASKCMD_SCAN){
+        wm->WiFi_scanNetworks(true,true);
+      }
+    }
+
+    if(wm->process()) wm->portalTaskPostEvent(WM_TASKEVT_CONNECTED);
+    wm->portalTaskUpdateStatus();
+
+    bool done = wm->_portalTaskExit || (!wm->configPortalActive && !wm->webPortalActive);
+    xSemaphoreGiveRecursive(wm->_portalMutex);
+    if(done) break;
+    vTaskDelay(1); // let idle and lower priority tasks run
+  }
+
+  wm->portalTaskPostEvent(WM_TASKEVT_CLOSED);
+  #ifdef WM_DEBUG_LEVEL
+  wm->DEBUG_WM(DEBUG_VERBOSE,F("portal task exiting"));
+  #endif
+  portENTER_CRITICAL(&wm->_taskMux);
+  TaskHandle_t waiter = wm->_portalTaskWaiter;
+  wm->_portalTask = NULL;
+  portEXIT_CRITICAL(&wm->_taskMux);
+  if(waiter) xTaskNotifyGive(waiter); // wm may be destroyed from here on
+  vTaskDelete(NULL);
+}
+
+/**
+ * stop the portal task and wait until it has exited on its own
+ * the task stops the portal from inside its loop, never deleted mid pass
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::portalTaskJoin(){
+  if(xTaskGetCurrentTaskHandle() == _portalTask) return; // from inside the task, it cannot wait on itself
+  portENTER_CRITICAL(&_taskMux);
+  bool running = _portalTask != NULL;
+  if(running) _portalTaskWaiter = xTaskGetCurrentTaskHandle();
+  portEXIT_CRITICAL(&_taskMux);
+  if(!running) return;
+
+  uint8_t c = WM_TASKCMD_STOP;
+  xQueueSend(_taskCmdQueue,&c,0); // a full queue is fine, the exit flag ends the task either way
+  _portalTaskExit = true;
+  ulTaskNotifyTake(pdTRUE,portMAX_DELAY);
+  _portalTaskWaiter = NULL;
+}
+
+/**
+ * copy portal state into the task status snapshot
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::portalTaskUpdateStatus(){
+  wm_taskstatus_t status;
+  status.configPortalActive = configPortalActive;
+  status.webPortalActive    = webPortalActive;
+  status.saving             = _saveState != SAVE_IDLE;
+  status.lastConxResult     = _lastconxresult;
+  status.processMaxLatency  = _processMaxLatency;
+  portENTER_CRITICAL(&_taskMux);
+  _taskStatus = status;
+  portEXIT_CRITICAL(&_taskMux);
+}
+
+/**
+ * post a task event, dropped if the app does not drain the queue
+ * @since $dev
+ * @access private
+ * @param  wm_taskevt_t evt
+ */
+void WiFiManager::portalTaskPostEvent(wm_taskevt_t evt){
+  uint8_t e = evt;
+  if(xQueueSend(_taskEvtQueue,&e,0) != pdTRUE){
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_DEV,F("portal task event queue full, dropped:"),e);
+    #endif
+  }
+}
+
+/**
+ * check if the portal task is running
+ * @since $dev
+ * @access public
+ * @return bool
+ */
+bool WiFiManager::getPortalTaskRunning(){
+  return _portalTask != NULL;
+}
+
+/**
+ * queue a command for the portal task
+ * @since $dev
+ * @access public
+ * @param  wm_taskcmd_t cmd
+ * @return bool queued
+ */
+bool WiFiManager::sendPortalTaskCommand(wm_taskcmd_t cmd){
+  if(!_portalTask || !_taskCmdQueue) return false;
+  uint8_t c = cmd;
+  return xQueueSend(_taskCmdQueue,&c,0) == pdTRUE;
+}
+
+/**
+ * receive a portal task event
+ * @since $dev
+ * @access public
+ * @param  wm_taskevt_t evt out
+ * @param  uint32_t waitms max ms to block, 0 polls
+ * @return bool event received
+ */
+bool WiFiManager::getPortalTaskEvent(wm_taskevt_t &evt, uint32_t waitms){
+  if(!_taskEvtQueue) return false;
+  uint8_t e;
+  if(xQueueReceive(_taskEvtQueue,&e,pdMS_TO_TICKS(waitms)) != pdTRUE) return false;
+  evt = (wm_taskevt_t)e;
+  return true;
+}
+
+/**
+ * get portal state safely from another core
+ * @since $dev
+ * @access public
+ * @return wm_taskstatus_t
+ */
+WiFiManager::wm_taskstatus_t WiFiManager::getPortalTaskStatus(){
+  if(!_portalTask) portalTaskUpdateStatus();
+  wm_taskstatus_t status;
+  portENTER_CRITICAL(&_taskMux);
+  status = _taskStatus;
+  portEXIT_CRITICAL(&_taskMux);
+  return status;
+}
+
   #ifdef WM_ARDUINOEVENTS
   void WiFiManager::WiFiEvent(WiFiEvent_t event,arduino_event_info_t info){
   #else
@@ -3785,7 +6417,11 @@ String WiFiManager::WiFi_psk(bool persistent) const {
     #define wifi_sta_disconnected disconnected
     #define ARDUINO_EVENT_WIFI_STA_DISCONNECTED SYSTEM_EVENT_STA_DISCONNECTED
     #define ARDUINO_EVENT_WIFI_SCAN_DONE SYSTEM_EVENT_SCAN_DONE
+    #define ARDUINO_EVENT_WIFI_STA_CONNECTED SYSTEM_EVENT_STA_CONNECTED
+    #define ARDUINO_EVENT_WIFI_STA_GOT_IP SYSTEM_EVENT_STA_GOT_IP
+    #define ARDUINO_EVENT_WIFI_AP_START SYSTEM_EVENT_AP_START
   #endif
+    if(event == ARDUINO_EVENT_WIFI_STA_CONNECTED || event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED) _staEventSeen = true;
     if(!_hasBegun){
       #ifdef WM_DEBUG_LEVEL
         // DEBUG_WM(DEBUG_VERBOSE,"[ERROR] WiFiEvent, not ready");
@@ -3802,15 +6438,15 @@ String WiFiManager::WiFi_psk(bool persistent) const {
     #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_VERBOSE,F("[EVENT] WIFI_REASON: "),info.wifi_sta_disconnected.reason);
       #endif
+      _lastdisconnectreason = info.wifi_sta_disconnected.reason;
+      connTimingEvent(CONNPHASE_DISCONNECTED,info.wifi_sta_disconnected.reason);
+      postWiFiEvent(WM_EVT_STADISCONNECTED);
       if(info.wifi_sta_disconnected.reason == WIFI_REASON_AUTH_EXPIRE || info.wifi_sta_disconnected.reason == WIFI_REASON_AUTH_FAIL){
         _lastconxresulttmp = 7; // hack in wrong password internally, sdk emit WIFI_REASON_AUTH_EXPIRE on some routers on auth_fail
       } else _lastconxresulttmp = WiFi.status();
       #ifdef WM_DEBUG_LEVEL
       if(info.wifi_sta_disconnected.reason == WIFI_REASON_NO_AP_FOUND) DEBUG_WM(DEBUG_VERBOSE,F("[EVENT] WIFI_REASON: NO_AP_FOUND"));
-      if(info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_FAIL){
-        if(_aggresiveReconn) _connectRetries+=4;
-        DEBUG_WM(DEBUG_VERBOSE,F("[EVENT] WIFI_REASON: AUTH FAIL"));
-      }  
+      if(info.wifi_sta_disconnected.reason == WIFI_REASON_ASSOC_FAIL) DEBUG_WM(DEBUG_VERBOSE,F("[EVENT] WIFI_REASON: ASSOC FAIL"));
       #endif
       #ifdef esp32autoreconnect
       #ifdef WM_DEBUG_LEVEL
@@ -3819,26 +6455,125 @@ String WiFiManager::WiFi_psk(bool persistent) const {
         WiFi.reconnect();
       #endif
   }
+  else if(event == ARDUINO_EVENT_WIFI_STA_CONNECTED){
+    connTimingEvent(CONNPHASE_CONNECTED);
+  }
+  else if(event == ARDUINO_EVENT_WIFI_STA_GOT_IP){
+    connTimingEvent(CONNPHASE_GOTIP);
+    postWiFiEvent(WM_EVT_STAGOTIP);
+  }
+  else if(event == ARDUINO_EVENT_WIFI_AP_START){
+    _apstarted = true;
+  }
   else if(event == ARDUINO_EVENT_WIFI_SCAN_DONE && _asyncScan){
-    uint16_t scans = WiFi.scanComplete();
-    WiFi_scanComplete(scans);
+    _scanDone = WiFi.scanComplete(); // completed on the loop side, clock hook and logging stay off this task
   }
 }
 #endif
 
 void WiFiManager::WiFi_autoReconnect(){
   #ifdef ESP8266
-    WiFi.setAutoReconnect(_wifiAutoReconnect);
+    WiFi.setAutoReconnect(_wifiAutoReconnect && !_reconnBackoff); // reconnect scheduler owns reconnects
+  #elif defined(ESP32)
+    if(_reconnBackoff) WiFi.setAutoReconnect(false); // reconnect scheduler owns reconnects
+  #endif
+  WiFi_initEvents();
+}
+
+/**
+ * install wifi event handlers once, used by connect timing and ap readiness
+ * @since $dev
+ * @access private
+ */
+void WiFiManager::WiFi_initEvents(){
+  #ifdef ESP8266
+    // sta events for connect timing, handlers unregister when released
+    if(!_evtconnected){
+      _evtconnected    = WiFi.onStationModeConnected([this](const WiFiEventStationModeConnected&){ connTimingEvent(CONNPHASE_CONNECTED); });
+      _evtgotip        = WiFi.onStationModeGotIP([this](const WiFiEventStationModeGotIP&){
+        connTimingEvent(CONNPHASE_GOTIP);
+        postWiFiEvent(WM_EVT_STAGOTIP);
+      });
+      _evtdisconnected = WiFi.onStationModeDisconnected([this](const WiFiEventStationModeDisconnected& evt){
+        connTimingEvent(CONNPHASE_DISCONNECTED,(uint8_t)evt.reason);
+        postWiFiEvent(WM_EVT_STADISCONNECTED);
+      });
+    }
   #elif defined(ESP32)
-    // if(_wifiAutoReconnect){
-      // @todo move to seperate method, used for event listener now
+    if(wm_event_id != 0) return;
+    #ifdef WM_DEBUG_LEVEL
+    DEBUG_WM(DEBUG_VERBOSE,F("ESP32 event handler enabled"));
+    #endif
+    using namespace std::placeholders;
+    wm_event_id = WiFi.onEvent(std::bind(&WiFiManager::WiFiEvent,this,_1,_2));
+  #endif
+}
+
+/**
+ * wait for the softap to drop its clients after softAPdisconnect
+ * @since $dev
+ * @access private
+ * @param  unsigned long timeout ms
+ * @return bool idle, false on timeout
+ */
+bool WiFiManager::WiFi_waitAPIdle(unsigned long timeout){
+  timerArm(WM_TIMER_WAIT,timeout);
+  while(WiFi_softap_num_stations() > 0){
+    if(timerExpired(WM_TIMER_WAIT)){
+      timerStop(WM_TIMER_WAIT);
       #ifdef WM_DEBUG_LEVEL
-      DEBUG_WM(DEBUG_VERBOSE,F("ESP32 event handler enabled"));
+      DEBUG_WM(DEBUG_ERROR,F("[ERROR] AP clients still connected after ms:"),timeout);
       #endif
-      using namespace std::placeholders;
-      if(wm_event_id == 0) wm_event_id = WiFi.onEvent(std::bind(&WiFiManager::WiFiEvent,this,_1,_2));
-    // }
+      return false;
+    }
+    _delay(10);
+  }
+  timerStop(WM_TIMER_WAIT);
+  return true;
+}
+
+/**
+ * wait for a wifi mode bit to be set
+ * @since $dev
+ * @access private
+ * @param  WiFiMode_t mode WIFI_STA or WIFI_AP
+ * @param  unsigned long timeout ms
+ * @return bool set, false on timeout
+ */
+bool WiFiManager::WiFi_waitMode(WiFiMode_t mode, unsigned long timeout){
+  timerArm(WM_TIMER_WAIT,timeout);
+  bool set;
+  while(!(set = (WiFi.getMode() & mode) == mode) && !timerExpired(WM_TIMER_WAIT)) _delay(10);
+  timerStop(WM_TIMER_WAIT);
+  return set;
+}
+
+/**
+ * wait for the softap to be up, replaces fixed settle delays
+ * esp32 waits for AP_START, esp8266 has no ap start event and polls ap mode and ip
+ * @since $dev
+ * @access private
+ * @param  unsigned long timeout ms
+ * @return bool ready, false on timeout
+ */
+bool WiFiManager::WiFi_waitAPReady(unsigned long timeout){
+  timerArm(WM_TIMER_WAIT,timeout);
+  while(!timerExpired(WM_TIMER_WAIT)){
+    bool ready = (WiFi.getMode() & WIFI_AP) && (uint32_t)WiFi.softAPIP() != 0;
+    #ifdef ESP32
+    if(!_apstarted) ready = false; // ip is static on esp32, only the event tells us the netif is up
+    #endif
+    if(ready){
+      timerStop(WM_TIMER_WAIT);
+      return true;
+    }
+    _delay(10);
+  }
+  timerStop(WM_TIMER_WAIT);
+  #ifdef WM_DEBUG_LEVEL
+  DEBUG_WM(DEBUG_ERROR,F("[ERROR] AP not ready after ms:"),timeout);
   #endif
+  return false;
 }
 
 // Called when /update is requested
@@ -3847,21 +6582,39 @@ void WiFiManager::handleUpdate() {
 	DEBUG_WM(DEBUG_VERBOSE,F("<- Handle update"));
   #endif
 	if (captivePortal()) return; // If captive portal redirect instead of displaying the page
-	String page = getHTTPHead(_title); // @token options
+	HTTPSendBegin();
+	HTTPSendHead(_title); // @token options
 	String str = FPSTR(HTTP_ROOT_MAIN);
   str.replace(FPSTR(T_t), _title);
 	str.replace(FPSTR(T_v), configPortalActive ? _apName : (getWiFiHostname() + " - " + WiFi.localIP().toString())); // use ip if ap is not active for heading
-	page += str;
-
-	page += FPSTR(HTTP_UPDATE);
-	page += FPSTR(HTTP_END);
+	HTTPSendS(str);
 
-	HTTPSend(page);
+	HTTPSendP(HTTP_UPDATE);
+	HTTPSendP(HTTP_END);
+	HTTPSendEnd();
 
 }
 
-// upload via /u POST
+#ifndef WM_ASYNCWEBSERVER
+// upload via /u POST, core webserver upload handler
 void WiFiManager::handleUpdating(){
+	HTTPUpload& upload = _appServer ? _appServer->upload() : server->upload();
+  wm_otastep_t step = WM_OTA_ABORT;
+  if(upload.status == UPLOAD_FILE_START) step = WM_OTA_START;
+  else if(upload.status == UPLOAD_FILE_WRITE) step = WM_OTA_WRITE;
+  else if(upload.status == UPLOAD_FILE_END) step = WM_OTA_END;
+  handleUpload(step, upload.filename, upload.buf, upload.currentSize, upload.totalSize);
+	delay(0);
+}
+#endif
+
+/**
+ * ota upload steps, from the core upload handler or the async upload callback
+ * on the async backend this runs in the async context, it must not delay or yield
+ * @param step   start, write a chunk, end or abort
+ * @param data,len chunk on write, total bytes on end
+ */
+void WiFiManager::handleUpload(wm_otastep_t step, const String &filename, uint8_t *data, size_t len, size_t total){
   // @todo
   // cannot upload files in captive portal, file select is not allowed, show message with link or hide
   // cannot upload if softreset after upload, maybe check for hard reset at least for dev, ERROR[11]: Invalid bootstrapping state, reset ESP8266 before updating
@@ -3874,16 +6627,16 @@ void WiFiManager::handleUpdating(){
   // convert output to debugger if not moving to example
 	
   // if (captivePortal()) return; // If captive portal redirect instead of displaying the page
+  if(!configPortalActive && !webPortalActive) return; // kept server while stopped, upload is ignored, done sends 503
   bool error = false;
   unsigned long _configPortalTimeoutSAV = _configPortalTimeout; // store cp timeout
   _configPortalTimeout = 0; // disable timeout
 
   // handler for the file upload, get's the sketch bytes, and writes
 	// them through the Update object
-	HTTPUpload& upload = server->upload();
 
   // UPLOAD START
-	if (upload.status == UPLOAD_FILE_START) {
+	if (step == WM_OTA_START) {
 	  // if(_debug) Serial.setDebugOutput(true);
     uint32_t maxSketchSpace;
     
@@ -3891,6 +6644,7 @@ void WiFiManager::handleUpdating(){
     if (_preotaupdatecallback != NULL) {
       _preotaupdatecallback();  // @CALLBACK
     }
+    postPortalEvent(WM_EVT_OTASTART);
     #ifdef ESP8266
     		WiFiUDP::stopAll();
     		maxSketchSpace = (ESP.getFreeSketchSpace() - 0x1000) & 0xFFFFF000;
@@ -3902,7 +6656,11 @@ void WiFiManager::handleUpdating(){
     #endif
 
     #ifdef WM_DEBUG_LEVEL
-    DEBUG_WM(DEBUG_VERBOSE,"[OTA] Update file: ", upload.filename.c_str());
+    DEBUG_WM(DEBUG_VERBOSE,"[OTA] Update file: ", filename.c_str());
+    #endif
+
+    #if defined(ESP8266) && defined(WM_ASYNCWEBSERVER)
+    Update.runAsync(true); // written from the sys context, no yielding
     #endif
 
     // Update.onProgress(THandlerFunction_Progress fn);
@@ -3919,9 +6677,9 @@ void WiFiManager::handleUpdating(){
   	}
 	}
   // UPLOAD WRITE
-  else if (upload.status == UPLOAD_FILE_WRITE) {
+  else if (step == WM_OTA_WRITE) {
 		// Serial.print(".");
-		if (Update.write(upload.buf, upload.currentSize) != upload.currentSize) {
+		if (Update.write(data, len) != len) {
       #ifdef WM_DEBUG_LEVEL
       DEBUG_WM(DEBUG_ERROR,F("[ERROR] OTA Update WRITE ERROR"), Update.getError());
 			//Update.printError(Serial); // write failure
@@ -3930,10 +6688,10 @@ void WiFiManager::handleUpdating(){
 		}
 	}
   // UPLOAD FILE END
-  else if (upload.status == UPLOAD_FILE_END) {
+  else if (step == WM_OTA_END) {
 		if (Update.end(true)) { // true to set the size to the current progress
       #ifdef WM_DEBUG_LEVEL
-      DEBUG_WM(DEBUG_VERBOSE,F("\n\n[OTA] OTA FILE END bytes: "), upload.totalSize);
+      DEBUG_WM(DEBUG_VERBOSE,F("\n\n[OTA] OTA FILE END bytes: "), total);
 			// Serial.printf("Updated: %u bytes\r\nRebooting...\r\n", upload.totalSize);
       #endif
 		}
@@ -3943,42 +6701,42 @@ void WiFiManager::handleUpdating(){
 		}
 	}
   // UPLOAD ABORT
-  else if (upload.status == UPLOAD_FILE_ABORTED) {
+  else if (step == WM_OTA_ABORT) {
 		Update.end();
 		DEBUG_WM(F("[OTA] Update was aborted"));
     error = true;
   }
   if(error) _configPortalTimeout = _configPortalTimeoutSAV;
-	delay(0);
 }
 
 // upload and ota done, show status
 void WiFiManager::handleUpdateDone() {
 	DEBUG_WM(DEBUG_VERBOSE, F("<- Handle update done"));
 	// if (captivePortal()) return; // If captive portal redirect instead of displaying the page
+	if (handleStopped()) return;
 
-	String page = getHTTPHead(FPSTR(S_options)); // @token options
+	HTTPSendBegin();
+	HTTPSendHead(FPSTR(S_options)); // @token options
 	String str  = FPSTR(HTTP_ROOT_MAIN);
   str.replace(FPSTR(T_t),_title);
 	str.replace(FPSTR(T_v), configPortalActive ? _apName : WiFi.localIP().toString()); // use ip if ap is not active for heading
-	page += str;
+	HTTPSendS(str);
 
 	if (Update.hasError()) {
-		page += FPSTR(HTTP_UPDATE_FAIL);
+		HTTPSendP(HTTP_UPDATE_FAIL);
     #ifdef ESP32
-    page += "OTA Error: " + (String)Update.errorString();
+    HTTPSendS("OTA Error: " + (String)Update.errorString());
     #else
-    page += "OTA Error: " + (String)Update.getError();
+    HTTPSendS("OTA Error: " + (String)Update.getError());
     #endif
 		DEBUG_WM(F("[OTA] update failed"));
 	}
 	else {
-		page += FPSTR(HTTP_UPDATE_SUCCESS);
+		HTTPSendP(HTTP_UPDATE_SUCCESS);
 		DEBUG_WM(F("[OTA] update ok"));
 	}
-	page += FPSTR(HTTP_END);
-
-	HTTPSend(page);
+	HTTPSendP(HTTP_END);
+	HTTPSendEnd();
 
 	delay(1000); // send page
 	if (!Update.hasError()) {
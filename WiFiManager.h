@@ -21,11 +21,15 @@
 #endif
 
 #include <vector>
+#include <atomic>
+#include <climits>
 
 // #define WM_MDNS            // includes MDNS, also set MDNS with sethostname
 // #define WM_FIXERASECONFIG  // use erase flash fix
 // #define WM_ERASE_NVS       // esp32 erase(true) will erase NVS 
 // #define WM_RTC             // esp32 info page will include reset reasons
+// #define WM_CONNSTATS_RTC   // keep connect stats in rtc memory across soft reboots, esp8266 uses rtc user memory, see WM_CONNSTATS_RTCOFFSET
+// #define WM_ASYNCWEBSERVER  // serve the portal with ESPAsyncWebServer instead of the core webserver, needs AsyncTCP / ESPAsyncTCP
 
 // #define WM_JSTEST                      // build flag for enabling js xhr tests
 // #define WIFI_MANAGER_OVERRIDE_STRINGS // build flag for using own strings include
@@ -71,7 +75,11 @@
       #include "user_interface.h"
     }
     #include <ESP8266WiFi.h>
+    #ifndef WM_ASYNCWEBSERVER
     #include <ESP8266WebServer.h>
+    #else
+    #include <Updater.h>
+    #endif
 
     #ifdef WM_MDNS
         #include <ESP8266mDNS.h>
@@ -79,6 +87,7 @@
 
     #define WIFI_getChipId() ESP.getChipId() 
     #define WM_WIFIOPEN   ENC_TYPE_NONE
+    #define WM_WIFIWEP    ENC_TYPE_WEP
 
 #elif defined(ESP32)
 
@@ -88,8 +97,9 @@
     
     #define WIFI_getChipId() (uint32_t)ESP.getEfuseMac()
     #define WM_WIFIOPEN   WIFI_AUTH_OPEN
+    #define WM_WIFIWEP    WIFI_AUTH_WEP
 
-    #ifndef WEBSERVER_H
+    #if !defined(WEBSERVER_H) && !defined(WM_ASYNCWEBSERVER)
         #ifdef WM_WEBSERVERSHIM
             #include <WebServer.h>
         #else
@@ -132,6 +142,11 @@
 #include <DNSServer.h>
 #include <memory>
 
+#ifdef WM_ASYNCWEBSERVER
+    #include <ESPAsyncWebServer.h>
+    #include <deque>
+#endif
+
 
 // Include wm strings vars
 // Pass in strings env override via WM_STRINGS_FILE
@@ -190,11 +205,231 @@
     #define WIFI_MANAGER_MAX_PARAMS 5 // params will autoincrement and realloc by this amount when max is reached
 #endif
 
+#ifndef WM_SENDBUF_SIZE
+    #define WM_SENDBUF_SIZE 536 // dynamic page segments are sent in pieces of about this size, default tcp mss
+#endif
+
+#ifndef WM_CONNTIMING_SIZE
+    #define WM_CONNTIMING_SIZE 4 // connect attempts kept in the timing ring, see getConnectTiming
+#endif
+
+#ifndef WM_CONNSTATS_RTCOFFSET
+    #define WM_CONNSTATS_RTCOFFSET 32 // with WM_CONNSTATS_RTC, first esp8266 rtc user memory block of connect stats, uses 33 blocks (32-64)
+#endif
+
+#ifndef WM_FASTCONNECT_WAIT
+    #define WM_FASTCONNECT_WAIT 5000 // ms autoConnect fast path waits on a connect already in flight, then takes the full path
+#endif
+
+#ifndef WM_EVENTRING_SIZE
+    #define WM_EVENTRING_SIZE 8 // portal events buffered per ring, power of 2, see getPortalEvent
+#endif
+
+#ifndef WM_FORM_SLOTS
+    #define WM_FORM_SLOTS 32 // save form args indexed per request, power of 2, extra args are found by scan, see formIndex
+#endif
+
+#ifndef WM_ASYNC_QUEUE
+    #define WM_ASYNC_QUEUE 4 // async backend, requests waiting for process(), more get a 503
+#endif
+
+#ifndef WM_DEFLATE_WINDOW
+    #define WM_DEFLATE_WINDOW 1024 // gzip match window in bytes, ram used is about 2x window + 1k + WM_SENDBUF_SIZE, see setHTTPCompression
+#endif
+
 #define WFM_LABEL_BEFORE 1
 #define WFM_LABEL_AFTER 2
 #define WFM_NO_LABEL 0
 #define WFM_LABEL_DEFAULT 1
 
+// bounded single producer single consumer ring, lock and allocation free
+// head is only written by the producer, tail only by the consumer
+class WiFiManagerEventRing {
+  public:
+    bool          push(uint8_t evt); // producer, false and counted as dropped when full
+    bool          pop(uint8_t &evt); // consumer, false when empty
+    uint16_t      dropped();
+
+  private:
+    static_assert((WM_EVENTRING_SIZE & (WM_EVENTRING_SIZE - 1)) == 0 && WM_EVENTRING_SIZE <= 128, "WM_EVENTRING_SIZE must be a power of 2, max 128");
+    uint8_t               _buf[WM_EVENTRING_SIZE];
+    std::atomic<uint8_t>  _head{0};
+    std::atomic<uint8_t>  _tail{0};
+    std::atomic<uint16_t> _dropped{0};
+};
+
+// streaming gzip encoder, lz77 over a small window with fixed huffman codes, one deflate block
+// compressed output goes to the sink in pieces of up to WM_SENDBUF_SIZE
+class WiFiManagerDeflate {
+  public:
+    WiFiManagerDeflate(std::function<void(const uint8_t*,size_t)> sink);
+    void          write(const uint8_t *data, size_t len);
+    void          write_P(PGM_P data, size_t len);
+    void          finish();
+    uint32_t      totalIn(){ return _in; }
+    uint32_t      totalOut(){ return _out; }
+
+  private:
+    static const uint16_t WINDOW   = WM_DEFLATE_WINDOW;
+    static const uint16_t BUFSIZE  = WM_DEFLATE_WINDOW * 2;
+    static const uint16_t MAXMATCH = 258;
+    static const uint16_t HASHSIZE = 512;
+    static_assert(WM_DEFLATE_WINDOW >= MAXMATCH && WM_DEFLATE_WINDOW <= 16384, "WM_DEFLATE_WINDOW must be 258 - 16384");
+
+    void          feed(const uint8_t *data, size_t len, bool progmem);
+    void          compress(bool flush);
+    void          slide();
+    uint16_t      hash(uint16_t pos);
+    void          putBits(uint32_t value, uint8_t bits);
+    void          putHuff(uint16_t code, uint8_t bits);
+    void          putLength(uint16_t sym);
+    void          putMatch(uint16_t len, uint16_t dist);
+    void          putByte(uint8_t b);
+    void          flushOut();
+
+    std::function<void(const uint8_t*,size_t)> _sink;
+    uint8_t       _buf[BUFSIZE];       // history window plus lookahead
+    uint16_t      _head[HASHSIZE] = {}; // last position + 1 per 3 byte hash, 0 empty
+    uint8_t       _outbuf[WM_SENDBUF_SIZE];
+    uint16_t      _outlen  = 0;
+    uint16_t      _fill    = 0; // bytes in _buf
+    uint16_t      _pos     = 0; // next byte to encode
+    uint32_t      _bitbuf  = 0;
+    uint8_t       _bitcnt  = 0;
+    uint32_t      _crc     = 0xFFFFFFFF;
+    uint32_t      _in      = 0;
+    uint32_t      _out     = 0;
+};
+
+#ifdef WM_ASYNCWEBSERVER
+    typedef WebRequestMethodComposite WM_HTTPMethod;
+#else
+    typedef HTTPMethod WM_HTTPMethod;
+#endif
+
+// http backend, the portal handlers only talk to the server through this
+// strings returned stay valid until the next few calls, do not hold them across requests
+class WiFiManagerHTTP {
+  public:
+    virtual ~WiFiManagerHTTP(){}
+    // request
+    virtual const String& uri() = 0;
+    virtual WM_HTTPMethod method() = 0;
+    virtual int           args() = 0;
+    virtual const String& arg(int i) = 0;
+    virtual const String& argName(int i) = 0;
+    virtual bool          hasArg(const String &name) = 0;
+    virtual const String& hostHeader() = 0;
+    virtual const String& header(const String &name) = 0;
+    virtual IPAddress     localIP() = 0;
+    // response, headers first, then one of send, sendChunked + sendContent + sendChunkedEnd, or sendRaw
+    virtual void          sendHeader(const String &name, const String &value) = 0;
+    virtual void          send(int code, const String &type, const String &content) = 0;
+    virtual void          sendChunked(int code, const String &type) = 0;
+    virtual void          sendContent(const char *data, size_t len) = 0;
+    virtual void          sendContent_P(PGM_P data) = 0;
+    virtual void          sendChunkedEnd() = 0;
+    virtual void          sendRaw(const uint8_t *data, size_t len) = 0; // complete prebuilt response, closes the connection
+    virtual void          sendRaw_P(PGM_P data, size_t len) = 0;
+};
+
+#ifdef WM_ASYNCWEBSERVER
+// event driven backend, connections are read and written by the async stack without blocking process()
+// complete requests are copied into a small queue and handled from process(), so handlers may still delay or scan
+// handler output is queued per request in pieces and pulled by the async stack on client acks, writes never wait
+// the first piece hands the response to the request, the head and that piece go out before the handler continues
+class WM_AsyncResponse;
+
+class WiFiManagerHTTPAsync : public WiFiManagerHTTP {
+  friend class WM_AsyncResponse;
+
+  public:
+    WiFiManagerHTTPAsync(AsyncWebServer &server, std::function<void()> dispatch);
+    ~WiFiManagerHTTPAsync();
+    void          begin();    // take over the server notfound handler
+    void          onUpload(const char *uri, ArUploadHandlerFunction upload); // POST uri with an upload handler, queued once uploaded
+    bool          handle();   // serve the oldest queued request from process(), false if none
+    uint8_t       pending();  // requests waiting
+
+    const String& uri() override;
+    WM_HTTPMethod method() override;
+    int           args() override;
+    const String& arg(int i) override;
+    const String& argName(int i) override;
+    bool          hasArg(const String &name) override;
+    const String& hostHeader() override;
+    const String& header(const String &name) override;
+    IPAddress     localIP() override;
+    void          sendHeader(const String &name, const String &value) override;
+    void          send(int code, const String &type, const String &content) override;
+    void          sendChunked(int code, const String &type) override;
+    void          sendContent(const char *data, size_t len) override;
+    void          sendContent_P(PGM_P data) override;
+    void          sendChunkedEnd() override;
+    void          sendRaw(const uint8_t *data, size_t len) override;
+    void          sendRaw_P(PGM_P data, size_t len) override;
+
+  private:
+    // response body, shared with the WM_AsyncResponse the request owns
+    struct out_t {
+      std::deque<String> pieces;    // handler output not yet sent, about WM_SENDBUF_SIZE each
+      size_t        offset = 0;     // bytes of the front piece already sent
+      bool          ended  = false; // nothing more will be queued
+      bool          raw    = false; // pieces hold a complete prebuilt response, see sendRaw
+    };
+
+    // request copied on arrival, the slot is held until the client disconnects
+    typedef struct {
+      AsyncWebServerRequest *req;   // NULL once the client went away
+      bool          queued;         // waiting for handle
+      bool          busy;           // being handled
+      uint32_t      seq;            // arrival order
+      WM_HTTPMethod method;
+      IPAddress     localip;
+      String        uri;
+      String        host;
+      String        acceptenc;
+      std::vector<String> names;
+      std::vector<String> values;
+      std::shared_ptr<out_t> out;
+      WM_AsyncResponse *resp;       // owned by req once handed over, NULL before the first piece
+    } slot_t;
+
+    // outlives the backend while the server still holds callbacks into it
+    struct shared_t {
+      WiFiManagerHTTPAsync *owner = NULL;
+      #ifdef ESP32
+      SemaphoreHandle_t lock = NULL; // async_tcp task vs process(), recursive, closing a client calls back
+      ~shared_t(){ if(lock) vSemaphoreDelete(lock); }
+      #endif
+    };
+
+    static void   accept(std::shared_ptr<shared_t> ctl, AsyncWebServerRequest *request);
+    void          onRequest(AsyncWebServerRequest *request);
+    void          forget(AsyncWebServerRequest *request);
+    void          start(int code, const String &type, size_t length = 0, bool raw = false);
+    void          write(const char *data, size_t len, bool progmem = false); // queues a piece, never waits
+    void          respond(); // mark the response complete
+    void          flush();   // hand the response over, or have it pull the new piece, backend lock held
+    static void   lock(shared_t &ctl);
+    static void   unlock(shared_t &ctl);
+
+    AsyncWebServer &_server;
+    std::function<void()> _dispatch;
+    std::shared_ptr<shared_t> _ctl;
+    slot_t        _slots[WM_ASYNC_QUEUE];
+    int8_t        _cur   = -1;      // slot being handled
+    uint32_t      _seq   = 0;
+    bool          _started = false; // code and headers set
+    bool          _done  = false;   // response complete
+    int           _code  = 0;       // head of the response being built, used on hand over
+    String        _type;
+    size_t        _length = 0;      // content length if known up front, else chunked
+    std::vector<std::pair<String,String>> _headers; // collected until start
+    String        _empty;
+};
+#endif
+
 class WiFiManagerParameter {
   public:
     /** 
@@ -318,6 +553,14 @@ class WiFiManager
     //called when config portal is timeout
     void          setConfigPortalTimeoutCallback( std::function<void()> func );
 
+    //replace millis and delay used by timeouts and waits, eg. a virtual clock for tests, NULL restores
+    //without delayfunc waits advance the virtual clock by the time waited
+    void          setClock( std::function<unsigned long()> millisfunc, std::function<void(unsigned long)> delayfunc = NULL );
+
+    //replace WiFi.status() and WiFi.begin() used by connect, save and reconnect, eg. a simulated radio for tests, NULL restores
+    //beginfunc gets ssid and pass, both NULL for the stored config
+    void          setWiFiSim( std::function<uint8_t()> statusfunc, std::function<bool(const char*,const char*)> beginfunc = NULL );
+
     //sets timeout before AP,webserver loop ends and exits even if there has been no setup.
     //useful for devices that failed to connect at some point and got stuck in a webserver loop
     //in seconds setConfigPortalTimeout is a new name for setTimeout, ! not used if setConfigPortalBlocking
@@ -329,7 +572,26 @@ class WiFiManager
 
     // sets number of retries for autoconnect, force retry after wait failure exit
     void          setConnectRetries(uint8_t numRetries); // default 1
-    
+
+    // autoConnect skips mode changes and begin when sta is already connected or connecting, default true
+    void          setFastAutoConnect(bool enable);
+
+    // enable non blocking reconnect scheduler in process(), exponential backoff from minms up to maxms, set before autoConnect
+    void          setReconnectBackoff(bool enable, unsigned long minms = 1000, unsigned long maxms = 60000);
+
+    // sleep ms per pass in the blocking portal loop while idle, bounds wake latency, 0 disabled
+    void          setConfigPortalIdleSleep(uint16_t ms);
+    // blocking portal loop cpu busy percent
+    uint8_t       getConfigPortalDutyCycle();
+    // ms until the earliest pending internal deadline, ULONG_MAX if none, for sleeping between process() calls
+    unsigned long getNextDeadline();
+
+    // max ms per process() call, unfinished tasks resume next call, 0 runs all tasks every call
+    void          setProcessBudget(unsigned long ms);
+
+    // check wifi saves against the last scan, reject impossible passwords and fail fast on missing ssids
+    void          setSaveValidation(bool enable); // default true
+
     //sets timeout for which to attempt connecting on saves, useful if there are bugs in esp waitforconnectloop
     void          setSaveConnectTimeout(unsigned long seconds);
     
@@ -434,6 +696,116 @@ class WiFiManager
 
     // get last connection result, includes autoconnect and wifisave
     uint8_t       getLastConxResult();
+
+    // connect attempt phase timings, ms from begin, 0 if phase not reached
+    // esp sdks raise link up only after assoc, auth and 4-way handshake, use reason to tell which failed
+    typedef struct {
+      unsigned long start;     // millis() at begin
+      unsigned long connected; // ms to link up
+      unsigned long gotip;     // ms to dhcp lease
+      unsigned long total;     // ms to result
+      uint8_t       status;    // wl_status_t result
+      uint8_t       reason;    // last disconnect reason during attempt, 0 if none
+    } wm_conntiming_t;
+
+    // number of recorded connect attempts, up to WM_CONNTIMING_SIZE
+    uint8_t       getConnectTimingCount();
+    // get connect timing n attempts back, 0 is most recent
+    wm_conntiming_t getConnectTiming(uint8_t n = 0);
+
+    // connect outcome telemetry, saturating counters
+    // reason slots: 0 none, 1-24 as is, 25 other, 26-35 are reasons 200-209
+    // duration bins: bin n is under 500ms << n, last bin is open ended
+    typedef struct {
+      uint16_t      status[9];    // attempts by wl_status_t result, last slot other
+      uint16_t      reason[36];   // attempts by last disconnect reason
+      uint16_t      connected[8]; // time to connect histogram
+      uint16_t      failed[8];    // time to failure histogram
+    } wm_connstats_t;
+
+    // cooperative tasks run by process() and the blocking portal loop
+    typedef enum {
+        WM_TASK_DNS       = 0, // captive dns, every pass
+        WM_TASK_HTTP      = 1,
+        WM_TASK_SAVE      = 2, // credential save state machine
+        WM_TASK_MDNS      = 3,
+        WM_TASK_RECONNECT = 4,
+        WM_TASK_MAX       = 5
+    } wm_task_t;
+
+    // worst case us of one process() or portal loop pass
+    unsigned long getProcessMaxLatency();
+    // worst case us of one task slice
+    unsigned long getTaskMaxTime(wm_task_t task);
+    void          resetProcessStats();
+
+    // http client pump, max requests per http slice, ms a stalled client may hold the server while others wait
+    void          setHTTPPump(uint8_t maxrequests = 4, unsigned long clienttimeout = 2000);
+
+    // gzip portal pages for clients that accept it, trades cpu and ~3k ram per response for airtime, default false
+    void          setHTTPCompression(bool enable);
+
+    // os captive portal probes, see handleProbe
+    typedef enum {
+        WM_PROBE_ANDROID = 0, // generate_204
+        WM_PROBE_APPLE   = 1, // hotspot-detect
+        WM_PROBE_WINDOWS = 2, // connecttest, ncsi
+        WM_PROBE_FIREFOX = 3, // success.txt
+        WM_PROBE_MAX     = 4
+    } wm_probe_t;
+
+    // http pump stats, reset by resetProcessStats
+    typedef struct {
+      uint32_t      requests;   // requests served
+      uint32_t      dropped;    // stalled or lingering clients closed for waiting ones
+      uint8_t       depthmax;   // max backlog seen by one slice, served plus still pending
+      unsigned long servicemax; // us worst case request
+      unsigned long serviceavg; // us mean request
+      unsigned long dispatchmax;// us worst case route lookup
+      uint32_t      gzipped;    // compressed responses
+      uint32_t      gzipin;     // bytes before compression
+      uint32_t      gzipout;    // bytes after compression, ratio is gzipout / gzipin
+      unsigned long gziptime;   // us spent compressing
+      uint32_t      probes[WM_PROBE_MAX]; // os captive probes answered by the fast path, per wm_probe_t
+      uint32_t      proberedirects; // of those, redirected to the portal instead of answered as online
+    } wm_httpstats_t;
+
+    wm_httpstats_t getHTTPStats();
+
+    // portal events, drained by the app instead of or next to the callbacks
+    typedef enum {
+        WM_EVT_NONE          = 0,
+        WM_EVT_SAVED         = 1, // wifi creds submitted
+        WM_EVT_PARAMSSAVED   = 2,
+        WM_EVT_CONNECTED     = 3, // portal save connected
+        WM_EVT_CONNECTFAILED = 4, // portal save failed to connect
+        WM_EVT_TIMEOUT       = 5, // config portal timed out
+        WM_EVT_OTASTART      = 6,
+        WM_EVT_STAGOTIP      = 7, // sta got ip, from wifi events
+        WM_EVT_STADISCONNECTED = 8 // sta lost link, from wifi events
+    } wm_event_t;
+
+    // queue portal events for getPortalEvent, default false
+    void          setPortalEvents(bool enable);
+    // pop the next portal event, false if none, call from one context only
+    bool          getPortalEvent(wm_event_t &evt);
+    // events lost to full rings
+    uint16_t      getPortalEventsDropped();
+
+    // ms the last startAP took until the softap was ready
+    unsigned long getAPStartDuration();
+    // ms the last config portal shutdown took
+    unsigned long getPortalShutdownDuration();
+    // ms the last autoConnect took until connected, 0 if it did not connect
+    unsigned long getAutoConnectDuration();
+    // true if the last autoConnect found sta already associated
+    bool          getAutoConnectFast();
+
+    // get connect stats, kept in rtc memory across soft reboots with WM_CONNSTATS_RTC, else since boot
+    wm_connstats_t getConnectStats();
+    // restore connect stats, eg. from app storage after a power loss
+    void          setConnectStats(const wm_connstats_t &stats);
+    void          resetConnectStats();
     
     // get a status as string
     String        getWLStatusString(uint8_t status);    
@@ -475,6 +847,9 @@ class WiFiManager
     // set port of webserver, 80
     void          setHttpPort(uint16_t port);
 
+    // keep the webserver and its routes allocated when the portal stops, restarts only reopen the listener
+    void          setWebServerPersistent(bool enable);
+
     // check if config portal is active (true)
     bool          getConfigPortalActive();
     
@@ -490,17 +865,143 @@ class WiFiManager
     // indicate if AP is currently in use
     bool          WifiAP_active(int max_uptime_minutes);
 
+    #ifdef ESP32
+    // portal task, runs process() in its own freertos task instead of the app loop
+    typedef enum {
+        WM_TASKCMD_STOP = 0, // stop the portal, task exits
+        WM_TASKCMD_SCAN = 1  // start an async wifi scan
+    } wm_taskcmd_t;
+
+    typedef enum {
+        WM_TASKEVT_CONNECTED = 0, // portal save connected
+        WM_TASKEVT_CLOSED    = 1  // portal closed, task exited
+    } wm_taskevt_t;
+
+    // consistent snapshot of portal state, updated by the task after every pass
+    typedef struct {
+      bool          configPortalActive;
+      bool          webPortalActive;
+      bool          saving;            // credential save in progress
+      uint8_t       lastConxResult;
+      unsigned long processMaxLatency; // us
+    } wm_taskstatus_t;
+
+    // start portal task pinned to core, start a non blocking config portal or web portal first
+    // while the task runs, safe from other tasks: start/stop config and web portal (serialised with the task),
+    // the portal task command/event/status calls below and the portal event rings
+    // setters and everything else must be called before startPortalTask or from callbacks, which run in the task
+    bool          startPortalTask(BaseType_t core = 0, uint32_t stackSize = 6144, UBaseType_t priority = 1);
+    bool          getPortalTaskRunning();
+    // queue a command to the portal task
+    bool          sendPortalTaskCommand(wm_taskcmd_t cmd);
+    // receive an event from the portal task, waits up to waitms
+    bool          getPortalTaskEvent(wm_taskevt_t &evt, uint32_t waitms = 0);
+    // thread safe portal state, live values if the task is not running
+    wm_taskstatus_t getPortalTaskStatus();
+    #endif
+
 
     std::unique_ptr<DNSServer>        dnsServer;
 
+    #ifdef WM_ASYNCWEBSERVER
+    std::unique_ptr<AsyncWebServer> server;
+    #else
     #if defined(ESP32) && defined(WM_WEBSERVERSHIM)
         using WM_WebServer = WebServer;
     #else
         using WM_WebServer = ESP8266WebServer;
     #endif
     
+    // the http pump reads protected webserver members, only on cores they were checked against
+    // other cores serve one client per process() pass
+    #if (defined(ESP8266) && defined(ARDUINO_ESP8266_MAJOR) && ARDUINO_ESP8266_MAJOR == 3) || \
+        (defined(ESP32) && defined(ESP_ARDUINO_VERSION_MAJOR) && ESP_ARDUINO_VERSION_MAJOR >= 2 && ESP_ARDUINO_VERSION_MAJOR <= 3)
+        #define WM_HTTPPUMP_INTERNALS
+    #endif
+
+    #ifdef ESP8266
+        using WM_RequestHandler = WM_WebServer::RequestHandlerType;
+    #else
+        using WM_RequestHandler = RequestHandler;
+    #endif
+
+    // exposes the pending connection and current client to the http pump, see processHTTP
+    // server is created as this type, public type stays WM_WebServer, only processHTTP downcasts
+    class WM_HTTPServer : public WM_WebServer {
+      public:
+        WM_HTTPServer(int port = 80) : WM_WebServer(port) {
+          addHandler(new WM_CountHandler(_requests)); // first in the chain, the server deletes it
+        }
+        uint32_t      requests(){ return _requests; } // parsed by the core, whichever handler served them
+        #ifdef WM_HTTPPUMP_INTERNALS
+        bool          clientPending(){ return _server.hasClient(); }
+        HTTPClientStatus clientStatus(){ return _currentStatus; }
+        unsigned long clientAge(){ return millis() - _statusChange; }
+        void          clientDrop(){ _currentClient.stop(); _currentStatus = HC_NONE; }
+        #else
+        bool          clientPending(){ return false; }
+        HTTPClientStatus clientStatus(){ return HC_NONE; }
+        unsigned long clientAge(){ return 0; }
+        void          clientDrop(){}
+        #endif
+
+      private:
+        // matches nothing, the core walks the handler chain once per parsed request
+        class WM_CountHandler : public WM_RequestHandler {
+          public:
+            WM_CountHandler(uint32_t &count) : _count(count) {}
+            bool canHandle(HTTPMethod method, const String &uri) { _count++; return false; }
+            bool canHandle(HTTPMethod method, String uri)        { _count++; return false; }
+            uint32_t &_count;
+        };
+        uint32_t      _requests = 0;
+    };
+
+    // core webserver backend, requests are handled inside handleClient
+    class WM_HTTPSync : public WiFiManagerHTTP {
+      public:
+        WM_HTTPSync(WM_WebServer &server) : _server(server) {}
+        const String& uri() override                     { return keep(_server.uri()); }
+        WM_HTTPMethod method() override                  { return _server.method(); }
+        int           args() override                    { return _server.args(); }
+        const String& arg(int i) override                { return keep(_server.arg(i)); }
+        const String& argName(int i) override            { return keep(_server.argName(i)); }
+        bool          hasArg(const String &name) override{ return _server.hasArg(name); }
+        const String& hostHeader() override              { return keep(_server.hostHeader()); }
+        const String& header(const String &name) override{ return keep(_server.header(name)); }
+        IPAddress     localIP() override                 { return _server.client().localIP(); }
+        void          sendHeader(const String &name, const String &value) override { _server.sendHeader(name, value); }
+        void          send(int code, const String &type, const String &content) override { _server.send(code, type, content); }
+        void          sendChunked(int code, const String &type) override { _server.setContentLength(CONTENT_LENGTH_UNKNOWN); _server.send(code, type, ""); }
+        void          sendContent(const char *data, size_t len) override { _server.sendContent(data, len); }
+        void          sendContent_P(PGM_P data) override { _server.sendContent_P(data); }
+        void          sendChunkedEnd() override          { _server.sendContent(String()); } // last chunk
+        void          sendRaw(const uint8_t *data, size_t len) override { _server.client().write(data, len); _server.client().stop(); }
+        void          sendRaw_P(PGM_P data, size_t len) override {
+          #ifdef ESP8266
+          _server.client().write_P(data, len);
+          #else
+          _server.client().write((const uint8_t*)data, len); // flash is mapped
+          #endif
+          _server.client().stop();
+        }
+
+      private:
+        // cores return request strings by reference or by value, values are parked here
+        const String& keep(const String &s){ return s; }
+        const String& keep(String &&s){ String &k = _keep[_keepNext++ & 3]; k = std::move(s); return k; }
+        WM_WebServer &_server;
+        String        _keep[4];
+        uint8_t       _keepNext = 0;
+    };
+
     std::unique_ptr<WM_WebServer> server;
 
+    // serve the web portal from an existing app webserver under prefix, no listener or buffers of its own
+    // the app keeps calling its handleClient, stopWebPortal removes only the portal routes
+    void          startWebPortal(WM_WebServer &server, const char *prefix = NULL);
+    #endif
+
   private:
     // vars
     std::vector<uint8_t> _menuIds;
@@ -517,13 +1018,11 @@ class WiFiManager
     IPAddress     _sta_static_sn;
     IPAddress     _sta_static_dns;
 
-    unsigned long _configPortalStart      = 0; // ms config portal start time (updated for timeouts)
     unsigned long _webPortalAccessed      = 0; // ms last web access time
     uint8_t       _lastconxresult         = WL_IDLE_STATUS; // store last result when doing connect operations
     int           _numNetworks            = 0; // init index for numnetworks wifiscans
     unsigned long _lastscan               = 0; // ms for timing wifi scans
     unsigned long _startscan              = 0; // ms for timing wifi scans
-    unsigned long _startconn              = 0; // ms for timing wifi connects
 
     // defaults
     const byte    DNS_PORT                = 53;
@@ -550,6 +1049,10 @@ class WiFiManager
     int32_t       _apChannel              = 0; // default channel to use for ap, 0 for auto
     bool          _apHidden               = false; // store softap hidden value
     uint16_t      _httpPort               = 80; // port for webserver
+    bool          _httpPersistent         = false; // keep server and routes across portal restarts
+    uint16_t      _httpServerPort         = 0; // port the kept server was created on
+    bool          _httpServerStale        = false; // compression or server callback changed, a kept server is recreated
+    bool          _httpServerClosed       = false; // kept server with its listener closed, after a blocking portal
     // uint8_t       _retryCount             = 0; // counter for retries, probably not needed if synchronous
     uint8_t       _connectRetries         = 1; // number of sta connect retries, force reconnect, wait loop (connectimeout) does not always work and first disconnect bails
     bool          _aggresiveReconn        = true; // use an agrressive reconnect strategy, WILL delay conxs
@@ -557,10 +1060,240 @@ class WiFiManager
                                                    // https://github.com/tzapu/WiFiManager/issues/1067
     bool          _allowExit              = true; // allow exit in nonblocking, else user exit/abort calls will be ignored including cptimeout
     bool          _WifiAP_active          = false;
+    unsigned long _apStartDuration        = 0; // ms last startAP took until ap ready
+    unsigned long _portalShutdownDuration = 0; // ms last shutdownConfigPortal took
+    bool          _fastAutoConnect        = true; // autoConnect fast path when sta already associated
+    bool          _autoConnectFast        = false; // last autoConnect took the fast path
+    unsigned long _autoConnectDuration    = 0; // ms last autoConnect took until connected
+    unsigned long _processBudget          = 0; // ms per process() call, 0 unlimited
+    bool          _portalEvents           = false; // queue wm_event_t, see setPortalEvents
+    uint16_t      _cpIdleSleep            = 0;   // ms blocking portal idle sleep, 0 disabled
+    unsigned long _cpBusyTime             = 0;   // us busy in current duty window
+    unsigned long _cpIdleTime             = 0;   // us slept in current duty window
+    uint8_t       _cpDutyCycle            = 100; // percent busy, last duty window
+    WiFiManagerEventRing _portalEventRing; // produced by the portal context
+    WiFiManagerEventRing _wifiEventRing;   // produced by the wifi event context
+    uint8_t       _taskNext               = WM_TASK_HTTP; // round robin resume point, dns is not rotated
+    unsigned long _processMaxLatency      = 0; // us worst case pass
+    unsigned long _taskMaxTime[WM_TASK_MAX] = {0}; // us worst case slice per task
+    uint8_t       _httpPumpMax            = 4;    // requests per http slice, 1 is one handleClient per slice
+    unsigned long _httpClientTimeout      = 2000; // ms a client may wait on read while others are pending, 0 never drop
+    wm_httpstats_t _httpstats             = {};
+    unsigned long long _httpServiceTotal  = 0;    // us, for serviceavg
+    String        _sendbuf;                       // dynamic page segments, see HTTPSendBegin
+    bool          _httpCompression        = false; // gzip pages when accepted
+    std::unique_ptr<WiFiManagerDeflate> _deflate; // active for the current response only
+    std::unique_ptr<WiFiManagerHTTP> _http;       // request and response side of server, see setupHTTPServer
+    String        _httpPrefix;                    // portal path prefix when mounted on an app server
+
+    #ifndef WM_ASYNCWEBSERVER
+    // portal routes on an app server, see startWebPortal(server,prefix)
+    // both argument forms are declared, cores differ in passing the uri by value or reference
+    class WM_MountHandler : public WM_RequestHandler {
+      public:
+        WM_MountHandler(WiFiManager *wm) : _wm(wm) {}
+        ~WM_MountHandler();
+        bool canHandle(HTTPMethod method, const String &uri)                 { return _wm && _wm->mountMatch(uri, false); }
+        bool canHandle(HTTPMethod method, String uri)                        { return _wm && _wm->mountMatch(uri, false); }
+        bool canUpload(const String &uri)                                    { return _wm && _wm->mountMatch(uri, true); }
+        bool canUpload(String uri)                                           { return _wm && _wm->mountMatch(uri, true); }
+        bool handle(WM_WebServer &server, HTTPMethod method, const String &uri) { return _wm && _wm->mountHandle(method, uri); }
+        bool handle(WM_WebServer &server, HTTPMethod method, String uri)     { return _wm && _wm->mountHandle(method, uri); }
+        void upload(WM_WebServer &server, const String &uri, HTTPUpload &upload) { if(_wm) _wm->handleUpdating(); }
+        void upload(WM_WebServer &server, String uri, HTTPUpload &upload)    { if(_wm) _wm->handleUpdating(); }
+        WiFiManager  *_wm; // NULL once unmounted, the handler then never matches
+    };
+
+    WM_WebServer *_appServer              = NULL; // app server the portal is mounted on
+    std::unique_ptr<WM_MountHandler> _mountHandler;
+    #endif
+
+    // save form index, name hash to server arg, built once per save request, see formIndex
+    typedef struct {
+      uint16_t      hash;    // folded fnv-1a of the arg name
+      uint8_t       len;     // name length, 0xFF for 255 and longer
+      uint8_t       arg;     // server arg index, 0xFF empty
+    } wm_formslot_t;
+
+    wm_formslot_t _formSlots[WM_FORM_SLOTS];
+    bool          _formOverflow           = false; // args that did not fit the index
+
+    // reconnect scheduler, see processReconnect
+    typedef enum {
+        RECONN_RETRY    = 0, // unknown failure, normal exponential backoff
+        RECONN_FAST     = 1, // assoc fail, retry at min interval
+        RECONN_SLOW     = 2, // ap not found, backoff grows faster
+        RECONN_STOP     = 3  // wrong password, stop retrying until creds change
+    } wm_reconnpolicy_t;
+
+    bool          _reconnBackoff          = false; // use non blocking reconnect scheduler in process(), disables esp autoreconnect
+    unsigned long _reconnMin              = 1000;  // ms min backoff interval
+    unsigned long _reconnMax              = 60000; // ms max backoff interval cap
+    unsigned long _reconnDelay            = 0;     // ms current backoff interval
+    uint8_t       _reconnAttempts         = 0;     // failed attempts since last connect
+    uint8_t       _reconnFastRetries      = 3;     // attempts at min interval for RECONN_FAST before backing off
+    bool          _reconnActive           = false; // attempt in flight, waiting on status
+    bool          _reconnHalted           = false; // stopped by RECONN_STOP policy
+
+    // connect timing ring, see connTimingBegin
+    typedef enum {
+        CONNPHASE_CONNECTED    = 0, // sta link up
+        CONNPHASE_GOTIP        = 1, // dhcp lease
+        CONNPHASE_DISCONNECTED = 2  // disconnect event, records reason
+    } wm_connphase_t;
+
+    wm_conntiming_t _conntiming[WM_CONNTIMING_SIZE];
+    uint8_t       _conntimingHead         = 0; // index of most recent attempt
+    uint8_t       _conntimingCount        = 0; // recorded attempts
+    bool          _conntimingOpen         = false; // most recent attempt awaiting result
+    // stamps from wifi event handlers, esp32 runs them in the event task
+    // handlers only store here, the record is filled and closed on the loop side, see connTimingPoll
+    volatile unsigned long _connevtConnected = 0; // millis() at link up, 0 not seen
+    volatile unsigned long _connevtGotIP     = 0; // millis() at dhcp lease, 0 not seen
+    volatile uint8_t       _connevtReason    = 0; // last disconnect reason, 0 none
+    wm_connstats_t _connstats;
+    bool          _connstatsLoaded        = false; // rtc copy read
+
+    // deadline timers, one slot per timeout, see timerArm
+    typedef enum {
+        WM_TIMER_PORTAL      = 0, // config portal timeout, bumped by clients and saves
+        WM_TIMER_SAVE        = 1, // current portal save state
+        WM_TIMER_CONNECT     = 2, // waitForConnectResult
+        WM_TIMER_RECONNECT   = 3, // reconnect attempt timeout or backoff interval
+        WM_TIMER_WAIT        = 4, // blocking mode and softap waits
+        WM_TIMER_LOG         = 5, // portal client and timeout log throttle, passive from here on
+        WM_TIMER_SCANCACHE   = 6, // wifi scan results age
+        WM_TIMER_AUTOCONNECT = 7, // since autoConnect started, duration and WifiAP_active uptime
+        WM_TIMER_MAX         = 8
+    } wm_timer_t;
+
+    // timers before WM_TIMER_LOG are deadlines for getNextDeadline, passive ones never wake the loop
+    static const uint8_t _timerDeadlines = WM_TIMER_LOG;
+
+    typedef struct {
+      unsigned long start;    // ms armed
+      unsigned long interval; // ms until due
+      bool          armed;
+    } wm_deadline_t;
+
+    wm_deadline_t _timers[WM_TIMER_MAX] = {};
+    int8_t        _timerNext              = -1; // armed timer due first, -1 none
+
+    // http methods a route accepts, backend independent, see routeMethod
+    enum {
+        WM_ROUTE_GET      = 1, // GET and HEAD
+        WM_ROUTE_POST     = 2,
+        WM_ROUTE_GETPOST  = WM_ROUTE_GET | WM_ROUTE_POST
+    };
+
+    // portal routes, dispatched from one handler, see handleRoute
+    typedef struct {
+      const char *  path;    // PROGMEM route
+      uint8_t       len;
+      uint32_t      hash;    // routeHash(path)
+      uint8_t       methods; // WM_ROUTE_ flags
+      void (WiFiManager::*handler)();
+    } wm_route_t;
+
+    static const wm_route_t _routes[];
+    static const uint8_t    _routeSlots[32]; // route index + 1 by routeSlot(hash), 0 empty, built at compile time
+
+    // os captive probes, answered with a prebuilt response, see handleProbe
+    typedef struct {
+      const char *  path;    // PROGMEM route
+      uint8_t       len;
+      uint32_t      hash;    // routeHash(path)
+      wm_probe_t    os;
+      const char *  online;  // PROGMEM response once the portal is done
+      uint8_t       onlinelen;
+    } wm_proberoute_t;
+
+    static const wm_proberoute_t _probes[];
+    static const uint8_t         _probesCount;
+
+    // captive redirect, built once per portal ip, see buildCaptiveRedirect
+    IPAddress     _cpIP;
+    char          _cpHost[22]             = {0}; // ip[:port], compared against the Host header
+    uint8_t       _cpHostLen              = 0;
+    char          _cpRedirect[128]        = {0}; // full 302 response
+    uint8_t       _cpRedirectLen          = 0;
+
+    // fnv-1a, evaluated at compile time for the route table
+    static constexpr uint32_t routeHash(const char *s, uint32_t h = 2166136261UL){
+      return *s ? routeHash(s + 1, (h ^ (uint8_t)*s) * 16777619UL) : h;
+    }
+    static constexpr uint8_t routeLen(const char *s, uint8_t n = 0){
+      return *s ? routeLen(s + 1, n + 1) : n;
+    }
+    // dispatch slot of a route hash, the fold keeps the current routes collision free in 32 slots
+    static constexpr uint8_t routeSlot(uint32_t hash){
+      return (hash ^ (hash >> 17)) & 31;
+    }
+    // route index + 1 that lands in slot, 0 if none, first match wins
+    static constexpr uint8_t routeSlotIndex(uint8_t slot, const char * const *paths, uint8_t n, uint8_t i = 0){
+      return i == n ? 0 : (routeSlot(routeHash(paths[i])) == slot ? i + 1 : routeSlotIndex(slot, paths, n, i + 1));
+    }
+    static constexpr bool routeSlotsUnique(const char * const *paths, uint8_t n, uint8_t i = 0){
+      return i == n ? true : (routeSlotIndex(routeSlot(routeHash(paths[i])), paths, n) == i + 1 && routeSlotsUnique(paths, n, i + 1));
+    }
+
+    // portal save state machine, see processSave
+    typedef enum {
+        SAVE_IDLE       = 0, // no save pending
+        SAVE_CLOSEDELAY = 1, // wait _cpclosedelay so the save page reaches the client
+        SAVE_CONNECT    = 2, // begin sta connect to submitted creds
+        SAVE_WAIT       = 3  // poll status until connected, failed or timed out
+    } wm_savestate_t;
+
+    wm_savestate_t _saveState             = SAVE_IDLE;
+    uint8_t       _saveAttempt            = 0; // connect attempts for current save
+
+    // save pre-validation, see checkWifiSave
+    typedef enum {
+        SAVECHECK_OK       = 0, // consistent with scan, or nothing to check against
+        SAVECHECK_NOTFOUND = 1, // ssid not in scan, may be hidden, flagged
+        SAVECHECK_OPENPASS = 2, // password given for open network, flagged
+        SAVECHECK_NOPASS   = 3, // secured network, empty password, rejected
+        SAVECHECK_BADPASS  = 4  // password length invalid for encryption, rejected
+    } wm_savecheck_t;
+
+    bool          _saveValidation         = true;  // check saves against scan results
+    bool          _saveNotFound           = false; // ssid missing from scan at save, no ssid avail ends connect early
 
     #ifdef ESP32
     wifi_event_id_t wm_event_id           = 0;
     static uint8_t _lastconxresulttmp; // tmp var for esp32 callback
+    static uint8_t _lastdisconnectreason; // last WIFI_REASON from esp32 disconnect event
+    volatile bool _apstarted              = false; // AP_START event seen, see WiFi_waitAPReady
+    volatile bool _staEventSeen           = false; // sta connected or disconnected event seen, sdk is working on a connect
+    volatile int16_t _scanDone            = -1;    // scan done event result, handed to WiFi_scanComplete on the loop side
+
+    TaskHandle_t  _portalTask             = NULL; // see startPortalTask
+    QueueHandle_t _taskCmdQueue           = NULL; // wm_taskcmd_t, app to task
+    QueueHandle_t _taskEvtQueue           = NULL; // wm_taskevt_t, task to app
+    portMUX_TYPE  _taskMux                = portMUX_INITIALIZER_UNLOCKED; // guards _taskStatus, _portalTask exit
+    wm_taskstatus_t _taskStatus;
+    SemaphoreHandle_t _portalMutex        = NULL; // recursive, held by the task for each pass and by public start/stop
+    TaskHandle_t  _portalTaskWaiter       = NULL; // notified once the task has exited, see portalTaskJoin
+    volatile bool _portalTaskExit         = false; // task exits after its current pass
+
+    // holds _portalMutex for a scope, no-op until startPortalTask
+    class WM_PortalLock {
+      public:
+        WM_PortalLock(SemaphoreHandle_t mutex) : _mutex(mutex) { if(_mutex) xSemaphoreTakeRecursive(_mutex,portMAX_DELAY); }
+        ~WM_PortalLock() { if(_mutex) xSemaphoreGiveRecursive(_mutex); }
+      private:
+        SemaphoreHandle_t _mutex;
+    };
+
+    static void   portalTask(void *param);
+    void          portalTaskJoin();
+    void          portalTaskUpdateStatus();
+    void          portalTaskPostEvent(wm_taskevt_t evt);
+    #elif defined(ESP8266)
+    WiFiEventHandler _evtconnected;    // sta event handlers for connect timing
+    WiFiEventHandler _evtgotip;
+    WiFiEventHandler _evtdisconnected;
     #endif
 
     #ifndef WL_STATION_WRONG_PASSWORD
@@ -626,6 +1359,10 @@ class WiFiManager
     bool          _hasBegun               = false; // flag wm loaded,unloaded
     void          _begin();
     void          _end();
+    unsigned long _millis();
+    void          _delay(unsigned long ms);
+    uint8_t       WiFi_status();
+    bool          WiFi_begin(const char *ssid = NULL, const char *pass = NULL, bool connect = true);
 
     void          setupConfigPortal();
     bool          shutdownConfigPortal();
@@ -648,11 +1385,42 @@ class WiFiManager
     uint8_t       waitForConnectResult();
     uint8_t       waitForConnectResult(uint32_t timeout);
     void          updateConxResult(uint8_t status);
+    void          processReconnect();
+    wm_reconnpolicy_t getReconnectPolicy();
+    void          scheduleReconnect();
+    void          connTimingBegin();
+    void          connTimingEvent(wm_connphase_t phase, uint8_t reason = 0);
+    void          connTimingCollect();
+    unsigned long connTimingSince(unsigned long elapsed, unsigned long age);
+    void          connTimingPoll();
+    void          connTimingEnd(uint8_t status);
+    void          connStatsLoad();
+    void          connStatsSave();
+    void          connStatsRecord(const wm_conntiming_t &t);
 
     // webserver handlers
     void          HTTPSend(const String &content);
+    void          HTTPSendBegin(int code = 200);
+    void          HTTPSendHead(const String &title);
+    void          HTTPSendP(PGM_P content);
+    void          HTTPSendS(const String &content);
+    void          HTTPSendFlush();
+    void          HTTPSendEnd();
+    void          handleRoute();
+    bool          handleStopped();
+    bool          handleProbe(const char *path, uint32_t hash, uint8_t len);
+    const char *  routePath(const String &uri);
+    const wm_route_t * findRoute(const char *path, uint32_t hash, size_t len);
+    uint8_t       routeMethod();
+    #ifndef WM_ASYNCWEBSERVER
+    bool          mountMatch(const String &uri, bool upload);
+    bool          mountHandle(HTTPMethod method, const String &uri);
+    void          unmountWebPortal();
+    #endif
     void          handleRoot();
     void          handleWifi(boolean scan);
+    void          handleWifiScan();
+    void          handleWifiNoScan();
     void          handleWifiSave();
     void          handleInfo();
     void          handleReset();
@@ -661,19 +1429,53 @@ class WiFiManager
     void          handleClose();
     // void          handleErase();
     void          handleErase(boolean opt);
+    void          handleEraseWifi();
     void          handleParam();
     void          handleWiFiStatus();
     void          handleRequest();
     void          handleParamSave();
     void          doParamSave();
+    void          formIndex();
+    int           formFind(const char *name, bool pgm);
+    int           formArg(PGM_P name);
+    int           formParam(int i);
 
     boolean       captivePortal();
+    void          buildCaptiveRedirect(IPAddress ip);
     boolean       configPortalHasTimeout();
     uint8_t       processConfigPortal();
+    uint8_t       runTasks(uint8_t tasks);
+    uint8_t       runTask(wm_task_t task);
+    void          postPortalEvent(wm_event_t evt);
+    void          postWiFiEvent(wm_event_t evt);
+    uint8_t       processSave();
+    void          processHTTP();
+    bool          configPortalIdle();
+    bool          autoConnectFast();
+    void          timerArm(wm_timer_t id, unsigned long interval);
+    void          timerArm(wm_timer_t id, unsigned long interval, unsigned long start);
+    void          timerStop(wm_timer_t id);
+    bool          timerExpired(wm_timer_t id);
+    bool          timerEvery(wm_timer_t id, unsigned long interval);
+    unsigned long timerElapsed(wm_timer_t id);
+    unsigned long timerRemaining(wm_timer_t id);
+    void          timerUpdateNext();
+    uint8_t       finishSave(bool success);
+    wm_savecheck_t checkWifiSave(const String &ssid, const String &pass);
     void          stopCaptivePortal();
 	// OTA Update handler
+    typedef enum {
+        WM_OTA_START = 0,
+        WM_OTA_WRITE = 1,
+        WM_OTA_END   = 2,
+        WM_OTA_ABORT = 3
+    } wm_otastep_t;
+
 	void          handleUpdate();
+    #ifndef WM_ASYNCWEBSERVER
 	void          handleUpdating();
+    #endif
+	void          handleUpload(wm_otastep_t step, const String &filename, uint8_t *data, size_t len, size_t total);
 	void          handleUpdateDone();
 
 
@@ -686,7 +1488,13 @@ class WiFiManager
     bool          WiFi_eraseConfig();
     uint8_t       WiFi_softap_num_stations();
     bool          WiFi_hasAutoConnect();
+    bool          WiFi_isConnecting();
+    bool          WiFi_connectFailed(uint8_t status);
     void          WiFi_autoReconnect();
+    void          WiFi_initEvents();
+    bool          WiFi_waitAPReady(unsigned long timeout);
+    bool          WiFi_waitAPIdle(unsigned long timeout);
+    bool          WiFi_waitMode(WiFiMode_t mode, unsigned long timeout);
     String        WiFi_SSID(bool persistent = true) const;
     String        WiFi_psk(bool persistent = true) const;
     bool          WiFi_scanNetworks();
@@ -694,6 +1502,7 @@ class WiFiManager
     bool          WiFi_scanNetworks(unsigned int cachetime,bool async);
     bool          WiFi_scanNetworks(unsigned int cachetime);
     void          WiFi_scanComplete(int networksFound);
+    void          WiFi_scanPoll();
     bool          WiFiSetCountry();
 
     #ifdef ESP32
@@ -736,7 +1545,6 @@ class WiFiManager
     String        getIpForm(String id, String title, String value);
     String        getScanItemOut();
     String        getStaticOut();
-    String        getHTTPHead(String title);
     String        getMenuOut();
     //helpers
     boolean       isIp(String str);
@@ -755,7 +1563,6 @@ class WiFiManager
     boolean       portalTimeoutResult = false;
     boolean       portalAbortResult   = false;
     boolean       storeSTAmode        = true; // option store persistent STA mode in connectwifi 
-    int           timer               = 0;    // timer for debug throttle for numclients, and portal timeout messages
     
     // WiFiManagerParameter
     int         _paramsCount          = 0;
@@ -824,6 +1631,11 @@ class WiFiManager
     std::function<void()> _resetcallback;
     std::function<void()> _preotaupdatecallback;
     std::function<void()> _configportaltimeoutcallback;
+    std::function<unsigned long()> _millisfunc;
+    std::function<void(unsigned long)> _delayfunc;
+    unsigned long _clockWaited            = 0; // ms waited on a virtual clock without delayfunc, see _delay
+    std::function<uint8_t()> _statusfunc;
+    std::function<bool(const char*,const char*)> _beginfunc;
 
     template <class T>
     auto optionalIPFromString(T *obj, const char *s) -> decltype(  obj->fromString(s)  ) {
@@ -0,0 +1,57 @@
+/**
+ * startup_latency.ino
+ * manual on device benchmark, prints time spent in WiFiManager per startup phase
+ * autoConnect, config portal start and config portal shutdown
+ * nothing is compared or enforced, compare runs by hand on the same board and ap
+ * connect phases depend on the ap, run with a saved config
+ */
+#include <WiFiManager.h> // https://github.com/tzapu/WiFiManager
+
+WiFiManager wm;
+
+void report(const char* phase, unsigned long ms){
+  Serial.printf("[BENCH] %-14s %6lu ms\n",phase,ms);
+}
+
+void setup() {
+  Serial.begin(115200);
+  delay(1000);
+  Serial.println("\n Startup latency benchmark");
+
+  wm.setDebugOutput(false); // serial logging skews timings
+  wm.setEnableConfigPortal(false); // measure connect only
+  wm.setConnectTimeout(20);
+
+  // autoConnect
+  unsigned long start = millis();
+  bool res = wm.autoConnect();
+  unsigned long total = millis() - start;
+  if(res){
+    report("autoconnect",wm.getAutoConnectDuration());
+    Serial.printf("[BENCH] fast path: %s, setup overhead %lu ms\n",wm.getAutoConnectFast() ? "yes" : "no",total - wm.getAutoConnectDuration());
+    if(wm.getConnectTimingCount() > 0){
+      WiFiManager::wm_conntiming_t t = wm.getConnectTiming(0);
+      if(t.connected) report("assoc",t.connected);
+      if(t.gotip && t.connected) report("dhcp",t.gotip - t.connected);
+    }
+  }
+  else Serial.println("[BENCH] autoConnect failed, save credentials first, skipping connect phases");
+
+  // config portal start, non blocking so startConfigPortal returns once serving
+  wm.setConfigPortalBlocking(false);
+  start = millis();
+  wm.startConfigPortal("WM_BENCH");
+  report("portalstart",millis() - start);
+  report("apstart",wm.getAPStartDuration());
+
+  // let the portal run a few process passes before stopping
+  start = millis();
+  while(millis() - start < 2000) wm.process();
+
+  // config portal shutdown
+  wm.stopConfigPortal();
+  report("portalstop",wm.getPortalShutdownDuration());
+}
+
+void loop() {
+}
@@ -0,0 +1,177 @@
+/**
+ * portal phase benchmark on the virtual clock, times are ms of simulated radio and loop time
+ * _ns phases are host wall clock ns per request, keep their tolerance loose
+ * wm_bench [--update] baseline.txt
+ * baseline lines are "name value tolerance%", a phase over value plus tolerance and one loop step is a regression, exit 1
+ * --update rewrites the baseline with the measured values, keeping tolerances
+ */
+#include <WiFiManager.h>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <map>
+#include <chrono>
+
+namespace {
+
+struct Phase {
+  std::string   name;
+  unsigned long ms;
+};
+
+std::vector<Phase> phases;
+
+void record(const char *name, unsigned long ms){
+  phases.push_back(Phase{name, ms});
+}
+
+// loop like a sketch with a 1 ms loop, until done or ms pass, returns ms taken
+template<typename D>
+unsigned long loopUntil(WiFiManager &wm, unsigned long ms, D done){
+  unsigned long start = wmsim::elapsedMs();
+  while(!done() && wmsim::elapsedMs() - start < ms){
+    if(wm.process()) break;
+    delay(1);
+  }
+  return wmsim::elapsedMs() - start;
+}
+
+const wmsim::Pairs host = {{"Host", "192.168.4.1"}};
+
+// saved ap in range, autoConnect to got ip
+void autoConnect(){
+  wmsim::reset();
+  wmsim::addAP("home", "secret123");
+  wmsim::saveConfig("home", "secret123");
+  WiFiManager wm;
+  wm.autoConnect("wm-bench");
+  record("autoconnect", wm.getAutoConnectDuration());
+}
+
+// saved ap gone, autoConnect falls back to a non blocking portal, through to a save and shutdown
+void portal(){
+  wmsim::reset();
+  wmsim::addAP("home", "secret123");
+  wmsim::saveConfig("home", "secret123");
+  wmsim::removeAP("home");
+  WiFiManager wm;
+  wm.setConfigPortalBlocking(false);
+  wm.setConnectTimeout(10);
+
+  unsigned long start = wmsim::elapsedMs();
+  wm.autoConnect("wm-bench");
+  record("autoconnect_fail", wmsim::elapsedMs() - start);
+  record("ap_start", wm.getAPStartDuration());
+
+  wmsim::ResponseRef r = wmsim::request("GET", "/", {}, host);
+  record("page_root", loopUntil(wm, 10000, [&]{ return r->ended; }));
+
+  r = wmsim::request("GET", "/wifi", {}, host);
+  record("page_wifi", loopUntil(wm, 10000, [&]{ return r->ended; }));
+
+  wmsim::addAP("home", "secret123");
+  wmsim::request("POST", "/wifisave", {{"s", "home"}, {"p", "secret123"}}, host);
+  record("save_connect", loopUntil(wm, 70000, []{ return false; }));
+
+  if(wm.getConfigPortalActive()) wm.stopConfigPortal(); // closed by the save unless setDisableConfigPortal(false)
+  record("portal_shutdown", wm.getPortalShutdownDuration());
+}
+
+// blocking startConfigPortal, a client saves shortly after the ap is up
+void configPortal(){
+  wmsim::reset();
+  wmsim::addAP("home", "secret123");
+  WiFiManager wm;
+  wmsim::at(100, []{
+    wmsim::request("POST", "/wifisave", {{"s", "home"}, {"p", "secret123"}}, host);
+  });
+  unsigned long start = wmsim::elapsedMs();
+  wm.startConfigPortal("wm-bench");
+  record("configportal_save", wmsim::elapsedMs() - start);
+  record("configportal_shutdown", wm.getPortalShutdownDuration());
+}
+
+// requests through process(), the http pump and the route table, answered without page rendering
+void timeRequests(WiFiManager &wm, const char *name, const char *method, const char *uri){
+  const int n = 4000;
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for(int i = 0; i < n; i += 4){
+    for(int j = 0; j < 4; j++) wmsim::request(method, uri, {}, host);
+    wm.process();
+  }
+  std::chrono::nanoseconds took = std::chrono::steady_clock::now() - start;
+  record(name, (unsigned long)(took.count() / n));
+}
+
+void dispatch(){
+  wmsim::reset();
+  WiFiManager wm;
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("wm-bench");
+  timeRequests(wm, "dispatch_method_ns", "POST", "/info");  // route hit, 405
+  timeRequests(wm, "dispatch_miss_ns",   "GET",  "/nothere"); // table miss, probe miss, 404
+}
+
+struct Base {
+  unsigned long ms;
+  unsigned      tol;
+};
+
+} // namespace
+
+int main(int argc, char **argv){
+  bool update = false;
+  const char *path = nullptr;
+  for(int i = 1; i < argc; i++){
+    if(std::string(argv[i]) == "--update") update = true;
+    else path = argv[i];
+  }
+
+  autoConnect();
+  portal();
+  configPortal();
+  dispatch();
+
+  std::map<std::string, Base> base;
+  if(path){
+    std::ifstream in(path);
+    std::string line;
+    while(std::getline(in, line)){
+      if(line.empty() || line[0] == '#') continue;
+      std::istringstream ls(line);
+      std::string name;
+      Base b = {0, 10};
+      if(ls >> name >> b.ms){
+        ls >> b.tol;
+        base[name] = b;
+      }
+    }
+  }
+
+  int regressions = 0;
+  printf("%-24s %8s %8s %6s\n", "phase", "value", "base", "tol%");
+  for(const Phase &p : phases){
+    auto it = base.find(p.name);
+    if(it == base.end()){
+      printf("%-24s %8lu %8s %6s  new\n", p.name.c_str(), p.ms, "-", "-");
+      continue;
+    }
+    const Base &b = it->second;
+    unsigned long limit = b.ms + b.ms * b.tol / 100 + 1; // plus one 1 ms loop step
+    bool slow = p.ms > limit;
+    if(slow) regressions++;
+    printf("%-24s %8lu %8lu %6u  %s\n", p.name.c_str(), p.ms, b.ms, b.tol, slow ? "REGRESSION" : (p.ms < b.ms ? "faster" : "ok"));
+  }
+
+  if(update && path){
+    std::ofstream out(path);
+    out << "# phase value tolerance%, ms on the virtual clock, _ns phases host ns per request, regenerate with wm_bench --update baseline.txt\n";
+    for(const Phase &p : phases){
+      auto it = base.find(p.name);
+      out << p.name << " " << p.ms << " " << (it == base.end() ? 10 : it->second.tol) << "\n";
+    }
+    printf("baseline written to %s\n", path);
+    return 0;
+  }
+  return regressions ? 1 : 0;
+}
@@ -0,0 +1,250 @@
+/**
+ * host Arduino core, just enough of String, Print and timing for WiFiManager.cpp
+ * time is virtual, see sim.h, delay() advances it and runs the radio and webserver events that fall due
+ */
+#ifndef WM_HOST_ARDUINO_H
+#define WM_HOST_ARDUINO_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cctype>
+#include <cmath>
+#include <string>
+#include <functional>
+#include <algorithm>
+
+typedef uint8_t byte;
+typedef bool    boolean;
+typedef uint8_t uint8;
+
+#define PROGMEM
+#define HEX 16
+#define DEC 10
+
+class __FlashStringHelper;
+#define F(s)     (reinterpret_cast<const __FlashStringHelper*>(s))
+#define FPSTR(p) (reinterpret_cast<const __FlashStringHelper*>(p))
+#define PSTR(s)  (s)
+#define PGM_P    const char*
+#define strlen_P    strlen
+#define memcpy_P    memcpy
+#define strncmp_P   strncmp
+#define strcmp_P    strcmp
+#define strncpy_P   strncpy
+#define strcpy_P    strcpy
+#define snprintf_P  snprintf
+#define sprintf_P   sprintf
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+
+inline char* itoa(int v, char *s, int base){ sprintf(s, base == 16 ? "%x" : "%d", v); return s; }
+
+class String {
+  public:
+    String(){}
+    String(const char *c){ if(c) _s = c; }
+    String(const std::string &s) : _s(s) {}
+    String(const __FlashStringHelper *c){ if(c) _s = (const char*)c; }
+    explicit String(char c) : _s(1, c) {}
+    explicit String(unsigned char v, unsigned char base = 10){ _s = num(v, base); }
+    explicit String(int v, unsigned char base = 10){ _s = base == 10 ? std::to_string(v) : num((unsigned)v, base); }
+    explicit String(unsigned v, unsigned char base = 10){ _s = num(v, base); }
+    explicit String(long v, unsigned char base = 10){ _s = base == 10 ? std::to_string(v) : num((unsigned long)v, base); }
+    explicit String(unsigned long v, unsigned char base = 10){ _s = num(v, base); }
+    explicit String(long long v, unsigned char base = 10){ _s = std::to_string(v); }
+    explicit String(unsigned long long v, unsigned char base = 10){ _s = std::to_string(v); }
+    explicit String(float v, unsigned char decimals = 2){ _s = fixed(v, decimals); }
+    explicit String(double v, unsigned char decimals = 2){ _s = fixed(v, decimals); }
+
+    const char*  c_str() const { return _s.c_str(); }
+    unsigned int length() const { return _s.size(); }
+    bool         isEmpty() const { return _s.empty(); }
+    bool         reserve(unsigned int n){ _s.reserve(n); return true; }
+    const std::string &str() const { return _s; }
+
+    String& operator+=(const String &o){ _s += o._s; return *this; }
+    String& operator+=(const char *o){ if(o) _s += o; return *this; }
+    String& operator+=(const __FlashStringHelper *o){ if(o) _s += (const char*)o; return *this; }
+    String& operator+=(char c){ _s += c; return *this; }
+    String& operator+=(unsigned char v){ _s += std::to_string(v); return *this; }
+    String& operator+=(int v){ _s += std::to_string(v); return *this; }
+    String& operator+=(unsigned v){ _s += std::to_string(v); return *this; }
+    String& operator+=(long v){ _s += std::to_string(v); return *this; }
+    String& operator+=(unsigned long v){ _s += std::to_string(v); return *this; }
+    bool concat(const String &o){ _s += o._s; return true; }
+    bool concat(const char *c){ if(c) _s += c; return true; }
+    bool concat(const char *c, unsigned int n){ _s.append(c, n); return true; }
+    bool concat(char c){ _s += c; return true; }
+
+    bool operator==(const String &o) const { return _s == o._s; }
+    bool operator!=(const String &o) const { return _s != o._s; }
+    bool operator==(const char *o) const { return _s == (o ? o : ""); }
+    bool operator!=(const char *o) const { return !(*this == o); }
+    bool operator<(const String &o) const { return _s < o._s; }
+    bool equals(const String &o) const { return _s == o._s; }
+    bool equalsIgnoreCase(const String &o) const {
+      if(_s.size() != o._s.size()) return false;
+      for(size_t i = 0; i < _s.size(); i++) if(tolower((unsigned char)_s[i]) != tolower((unsigned char)o._s[i])) return false;
+      return true;
+    }
+    bool startsWith(const String &p) const { return _s.compare(0, p._s.size(), p._s) == 0; }
+    bool endsWith(const String &p) const { return _s.size() >= p._s.size() && _s.compare(_s.size() - p._s.size(), p._s.size(), p._s) == 0; }
+
+    int indexOf(char c, unsigned from = 0) const { return pos(_s.find(c, from)); }
+    int indexOf(const String &p, unsigned from = 0) const { return pos(_s.find(p._s, from)); }
+    int lastIndexOf(char c) const { return pos(_s.rfind(c)); }
+    int lastIndexOf(const String &p) const { return pos(_s.rfind(p._s)); }
+    String substring(unsigned from) const { return from < _s.size() ? String(_s.substr(from)) : String(); }
+    String substring(unsigned from, unsigned to) const {
+      if(from > to) std::swap(from, to);
+      if(from >= _s.size()) return String();
+      return String(_s.substr(from, std::min<size_t>(to, _s.size()) - from));
+    }
+    char charAt(unsigned i) const { return i < _s.size() ? _s[i] : 0; }
+    char operator[](unsigned i) const { return charAt(i); }
+    char& operator[](unsigned i){ return _s[i]; }
+    void setCharAt(unsigned i, char c){ if(i < _s.size()) _s[i] = c; }
+
+    void replace(const String &from, const String &to){
+      if(from._s.empty()) return;
+      for(size_t at = _s.find(from._s); at != std::string::npos; at = _s.find(from._s, at + to._s.size())) _s.replace(at, from._s.size(), to._s);
+    }
+    void replace(char from, char to){ std::replace(_s.begin(), _s.end(), from, to); }
+    void remove(unsigned i){ if(i < _s.size()) _s.erase(i); }
+    void remove(unsigned i, unsigned n){ if(i < _s.size()) _s.erase(i, n); }
+    void trim(){
+      size_t a = _s.find_first_not_of(" \t\r\n");
+      if(a == std::string::npos){ _s.clear(); return; }
+      _s = _s.substr(a, _s.find_last_not_of(" \t\r\n") - a + 1);
+    }
+    void toUpperCase(){ for(auto &c : _s) c = toupper((unsigned char)c); }
+    void toLowerCase(){ for(auto &c : _s) c = tolower((unsigned char)c); }
+    long  toInt() const { return atol(_s.c_str()); }
+    float toFloat() const { return atof(_s.c_str()); }
+    void toCharArray(char *buf, unsigned n) const { getBytes((unsigned char*)buf, n); }
+    void getBytes(unsigned char *buf, unsigned n) const {
+      if(!n) return;
+      size_t len = std::min<size_t>(n - 1, _s.size());
+      memcpy(buf, _s.data(), len);
+      buf[len] = 0;
+    }
+
+    explicit operator bool() const { return true; } // arduino String is truthy once allocated
+
+  private:
+    static int pos(size_t p){ return p == std::string::npos ? -1 : (int)p; }
+    static std::string num(unsigned long long v, unsigned char base){
+      if(base != 16) return std::to_string(v);
+      char buf[24];
+      snprintf(buf, sizeof(buf), "%llx", v);
+      return buf;
+    }
+    static std::string fixed(double v, unsigned char decimals){
+      char buf[48];
+      snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+      return buf;
+    }
+    std::string _s;
+};
+
+inline String operator+(const String &a, const String &b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, const char *b){ String r(a); r += b; return r; }
+inline String operator+(const char *a, const String &b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, const __FlashStringHelper *b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, char b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, int b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, unsigned b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, long b){ String r(a); r += b; return r; }
+inline String operator+(const String &a, unsigned long b){ String r(a); r += b; return r; }
+
+class Printable;
+
+class Print {
+  public:
+    virtual ~Print(){}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t n){ size_t w = 0; while(n--) w += write(*buf++); return w; }
+    size_t write(const char *buf, size_t n){ return write((const uint8_t*)buf, n); }
+    size_t write(const char *s){ return s ? write(s, strlen(s)) : 0; }
+
+    size_t print(const String &s){ return write(s.c_str(), s.length()); }
+    size_t print(const char *s){ return write(s); }
+    size_t print(const __FlashStringHelper *s){ return write((const char*)s); }
+    size_t print(char c){ return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC){ return print(String(v, base)); }
+    size_t print(int v, int base = DEC){ return print(String(v, base)); }
+    size_t print(unsigned v, int base = DEC){ return print(String(v, base)); }
+    size_t print(long v, int base = DEC){ return print(String(v, base)); }
+    size_t print(unsigned long v, int base = DEC){ return print(String(v, base)); }
+    size_t print(double v, int decimals = 2){ return print(String(v, decimals)); }
+    size_t print(const Printable &p);
+    template<typename T> size_t println(const T &v){ size_t n = print(v); return n + println(); }
+    size_t println(){ return write("\r\n"); }
+    size_t printf(const char *fmt, ...){
+      char buf[256];
+      va_list args;
+      va_start(args, fmt);
+      int n = vsnprintf(buf, sizeof(buf), fmt, args);
+      va_end(args);
+      return n > 0 ? write(buf, std::min<size_t>(n, sizeof(buf) - 1)) : 0;
+    }
+    size_t printf_P(const char *fmt, ...){
+      char buf[256];
+      va_list args;
+      va_start(args, fmt);
+      int n = vsnprintf(buf, sizeof(buf), fmt, args);
+      va_end(args);
+      return n > 0 ? write(buf, std::min<size_t>(n, sizeof(buf) - 1)) : 0;
+    }
+    virtual void flush(){}
+};
+
+class Printable {
+  public:
+    virtual ~Printable(){}
+    virtual size_t printTo(Print &p) const = 0;
+};
+
+inline size_t Print::print(const Printable &p){ return p.printTo(*this); }
+
+class Stream : public Print {
+  public:
+    virtual int available(){ return 0; }
+    virtual int read(){ return -1; }
+    virtual int peek(){ return -1; }
+};
+
+// serial output is dropped unless the sim echoes it, see wmsim::serialEcho
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long){}
+    void setDebugOutput(bool){}
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buf, size_t n) override;
+    using Print::write;
+};
+extern HardwareSerial Serial;
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline bool isAlphaNumeric(char c){ return isalnum((unsigned char)c); }
+template<class T, class L, class H> T constrain(T x, L lo, H hi){ return x < lo ? lo : (x > hi ? hi : x); }
+inline long map(long x, long in_min, long in_max, long out_min, long out_max){
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+#include "Esp.h"
+#include "Updater.h"
+
+#endif
@@ -0,0 +1,23 @@
+/**
+ * host DNSServer, the captive dns only counts how often it is polled, see wmsim::dnsPolls
+ */
+#ifndef WM_HOST_DNSSERVER_H
+#define WM_HOST_DNSSERVER_H
+
+#include "ESP8266WiFi.h"
+
+enum class DNSReplyCode { NoError = 0, FormError = 1, ServerFailure = 2, NonExistentDomain = 3 };
+
+class DNSServer {
+  public:
+    void setErrorReplyCode(const DNSReplyCode &replyCode){}
+    void setTTL(const uint32_t &ttl){}
+    bool start(const uint16_t &port, const String &domainName, const IPAddress &resolvedIP){ _started = true; return true; }
+    void stop(){ _started = false; }
+    void processNextRequest(){ if(_started) wmsim::dnsPolls++; }
+
+  private:
+    bool _started = false;
+};
+
+#endif
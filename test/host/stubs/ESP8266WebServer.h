@@ -0,0 +1,131 @@
+/**
+ * host ESP8266WebServer, same handler chain and response calls as the 3.x core
+ * handleClient takes one request from the simulated queue of its port, see wmsim::request
+ */
+#ifndef WM_HOST_ESP8266WEBSERVER_H
+#define WM_HOST_ESP8266WEBSERVER_H
+
+#include "ESP8266WiFi.h"
+
+enum HTTPMethod { HTTP_ANY, HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_PATCH, HTTP_DELETE, HTTP_OPTIONS };
+enum HTTPClientStatus { HC_NONE, HC_WAIT_READ, HC_WAIT_CLOSE };
+enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
+enum HTTPUploadStatus { UPLOAD_FILE_START, UPLOAD_FILE_WRITE, UPLOAD_FILE_END, UPLOAD_FILE_ABORTED };
+
+#define HTTP_UPLOAD_BUFLEN 2048
+#define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
+#define CONTENT_LENGTH_NOT_SET ((size_t) -2)
+
+struct HTTPUpload {
+  HTTPUploadStatus status;
+  String  filename;
+  String  name;
+  String  type;
+  size_t  totalSize;
+  size_t  currentSize;
+  uint8_t buf[HTTP_UPLOAD_BUFLEN];
+};
+
+class Uri {
+  public:
+    Uri(const char *uri) : _uri(uri) {}
+    Uri(const String &uri) : _uri(uri) {}
+    Uri(const __FlashStringHelper *uri) : _uri(uri) {}
+    const String &str() const { return _uri; }
+
+  private:
+    String _uri;
+};
+
+class ESP8266WebServer;
+
+class RequestHandler {
+  public:
+    virtual ~RequestHandler(){}
+    virtual bool canHandle(HTTPMethod method, const String &uri){ return false; }
+    virtual bool canUpload(const String &uri){ return false; }
+    virtual bool handle(ESP8266WebServer &server, HTTPMethod method, const String &uri){ return false; }
+    virtual void upload(ESP8266WebServer &server, const String &uri, HTTPUpload &upload){}
+    RequestHandler* next(){ return _next; }
+    void next(RequestHandler *r){ _next = r; }
+
+  private:
+    RequestHandler *_next = nullptr;
+};
+
+class ESP8266WebServer {
+  public:
+    typedef std::function<void(void)> THandlerFunction;
+    using RequestHandlerType = RequestHandler;
+
+    ESP8266WebServer(int port = 80) : _server(port) {}
+    virtual ~ESP8266WebServer();
+
+    void begin(){ _server.begin(); }
+    void begin(uint16_t port){ _server.begin(port); }
+    void close(){ _server.close(); }
+    void stop(){ close(); }
+    void handleClient();
+
+    void on(const Uri &uri, THandlerFunction fn){ on(uri, HTTP_ANY, fn); }
+    void on(const Uri &uri, HTTPMethod method, THandlerFunction fn){ on(uri, method, fn, THandlerFunction()); }
+    void on(const Uri &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn);
+    void addHandler(RequestHandler *handler);
+    bool removeHandler(RequestHandler *handler);
+    void onNotFound(THandlerFunction fn){ _notFound = fn; }
+
+    const String& uri() const { return _req.uri; }
+    HTTPMethod    method() const { return _method; }
+    WiFiClient&   client(){ return _currentClient; }
+    HTTPUpload&   upload(){ return _upload; }
+
+    const String& arg(const String &name) const;
+    const String& arg(int i) const;
+    const String& argName(int i) const;
+    int           args() const { return _req.args.size(); }
+    bool          hasArg(const String &name) const;
+    void          collectHeaders(const char *headerKeys[], const size_t headerKeysCount);
+    const String& header(const String &name) const;
+    const String& header(int i) const;
+    const String& headerName(int i) const;
+    int           headers() const { return _collected.size(); }
+    bool          hasHeader(const String &name) const;
+    const String& hostHeader() const;
+
+    bool authenticate(const char *username, const char *password){ return true; }
+    void requestAuthentication(HTTPAuthMethod mode = BASIC_AUTH, const char *realm = NULL, const String &authFailMsg = String()){ send(401); }
+
+    void send(int code, const char *content_type = NULL, const String &content = String());
+    void send(int code, char *content_type, const String &content){ send(code, (const char*)content_type, content); }
+    void send(int code, const String &content_type, const String &content){ send(code, content_type.c_str(), content); }
+    void send(int code, const __FlashStringHelper *content_type, const String &content){ send(code, (const char*)content_type, content); }
+    void send_P(int code, PGM_P content_type, PGM_P content){ send(code, content_type, String(content)); }
+    void send_P(int code, PGM_P content_type, PGM_P content, size_t len){ send(code, content_type, String(std::string(content, len))); }
+    void sendHeader(const String &name, const String &value, bool first = false);
+    void setContentLength(const size_t contentLength){ _contentLength = contentLength; }
+    void sendContent(const String &content){ sendContent(content.c_str(), content.length()); }
+    void sendContent(const char *content, size_t size);
+    void sendContent_P(PGM_P content){ sendContent(content, strlen_P(content)); }
+    void sendContent_P(PGM_P content, size_t size){ sendContent(content, size); }
+
+  protected:
+    WiFiServer        _server;
+    WiFiClient        _currentClient;
+    HTTPClientStatus  _currentStatus = HC_NONE;
+    unsigned long     _statusChange  = 0;
+
+  private:
+    wmsim::Request    _req;
+    HTTPMethod        _method        = HTTP_GET;
+    HTTPUpload        _upload        = {};
+    RequestHandler   *_firstHandler  = nullptr;
+    RequestHandler   *_lastHandler   = nullptr;
+    THandlerFunction  _notFound;
+    wmsim::Pairs      _collected;    // collectHeaders keys, values filled per request
+    wmsim::Pairs      _pendingHeaders;
+    size_t            _contentLength = CONTENT_LENGTH_NOT_SET;
+    bool              _chunked       = false;
+    std::shared_ptr<bool> _alive     = std::make_shared<bool>(true); // cleared when a handler deletes the server
+};
+
+#endif
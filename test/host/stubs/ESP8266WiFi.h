@@ -0,0 +1,219 @@
+/**
+ * host ESP8266WiFi, the class keeps the core api, state lives in the simulated radio, see sim.cpp
+ */
+#ifndef WM_HOST_ESP8266WIFI_H
+#define WM_HOST_ESP8266WIFI_H
+
+#include "Arduino.h"
+extern "C" {
+  #include "user_interface.h"
+}
+#include "sim.h"
+
+class IPAddress : public Printable {
+  public:
+    IPAddress(){}
+    IPAddress(uint32_t addr) : _addr(addr) {}
+    IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : _addr(a | (b << 8) | (c << 16) | ((uint32_t)d << 24)) {}
+    operator uint32_t() const { return _addr; }
+    bool operator==(const IPAddress &o) const { return _addr == o._addr; }
+    bool operator!=(const IPAddress &o) const { return _addr != o._addr; }
+    uint8_t operator[](int i) const { return (_addr >> (8 * i)) & 0xff; }
+    bool isSet() const { return _addr != 0; }
+    bool fromString(const char *s){
+      unsigned a, b, c, d;
+      char tail;
+      if(!s || sscanf(s, "%u.%u.%u.%u%c", &a, &b, &c, &d, &tail) != 4 || a > 255 || b > 255 || c > 255 || d > 255) return false;
+      *this = IPAddress(a, b, c, d);
+      return true;
+    }
+    bool fromString(const String &s){ return fromString(s.c_str()); }
+    String toString() const {
+      char buf[16];
+      snprintf(buf, sizeof(buf), "%u.%u.%u.%u", (*this)[0], (*this)[1], (*this)[2], (*this)[3]);
+      return String(buf);
+    }
+    size_t printTo(Print &p) const override { return p.print(toString()); }
+
+  private:
+    uint32_t _addr = 0;
+};
+
+// a client is the far end of one queued request, writes land in its response
+class WiFiClient : public Stream {
+  public:
+    WiFiClient(){}
+    WiFiClient(wmsim::ResponseRef resp, IPAddress local) : _resp(resp), _local(local) {}
+    size_t   write(uint8_t c) override { return write(&c, 1); }
+    size_t   write(const uint8_t *buf, size_t n) override;
+    size_t   write_P(PGM_P buf, size_t n){ return write((const uint8_t*)buf, n); }
+    using    Print::write;
+    void     stop();
+    uint8_t  connected(){ return _resp && !_resp->ended; }
+    uint8_t  status(){ return connected() ? 4 : 0; } // ESTABLISHED
+    void     setNoDelay(bool){}
+    IPAddress localIP(){ return _local; }
+    IPAddress remoteIP(){ return IPAddress(192, 168, 4, 2); }
+    uint16_t localPort(){ return 80; }
+    explicit operator bool() const { return (bool)_resp; }
+
+  private:
+    wmsim::ResponseRef _resp;
+    IPAddress          _local;
+};
+
+class WiFiServer {
+  public:
+    WiFiServer(uint16_t port) : _port(port) {}
+    ~WiFiServer(){ close(); }
+    void begin(){ begin(_port); }
+    void begin(uint16_t port){ close(); _port = port; wmsim::listen(_port, true); _listening = true; }
+    void close(){ if(_listening) wmsim::listen(_port, false); _listening = false; }
+    void stop(){ close(); }
+    bool hasClient(){ return _listening && wmsim::pending(_port) > 0; }
+    bool listening() const { return _listening; }
+    uint16_t port() const { return _port; }
+
+  private:
+    uint16_t _port;
+    bool     _listening = false;
+};
+
+class WiFiUDP {
+  public:
+    static void stopAll(){}
+};
+
+typedef enum { WIFI_OFF = 0, WIFI_STA = 1, WIFI_AP = 2, WIFI_AP_STA = 3 } WiFiMode_t;
+typedef enum { WIFI_NONE_SLEEP = 0, WIFI_LIGHT_SLEEP = 1, WIFI_MODEM_SLEEP = 2 } WiFiSleepType_t;
+typedef enum { WIFI_PHY_MODE_11B = 1, WIFI_PHY_MODE_11G = 2, WIFI_PHY_MODE_11N = 3 } WiFiPhyMode_t;
+
+typedef enum {
+  WL_NO_SHIELD       = 255,
+  WL_IDLE_STATUS     = 0,
+  WL_NO_SSID_AVAIL   = 1,
+  WL_SCAN_COMPLETED  = 2,
+  WL_CONNECTED       = 3,
+  WL_CONNECT_FAILED  = 4,
+  WL_CONNECTION_LOST = 5,
+  WL_WRONG_PASSWORD  = 6,
+  WL_DISCONNECTED    = 7
+} wl_status_t;
+
+enum wl_enc_type { ENC_TYPE_WEP = 5, ENC_TYPE_TKIP = 2, ENC_TYPE_CCMP = 4, ENC_TYPE_NONE = 7, ENC_TYPE_AUTO = 8 };
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED  (-2)
+
+typedef enum {
+  WIFI_EVENT_STAMODE_CONNECTED = 0,
+  WIFI_EVENT_STAMODE_DISCONNECTED,
+  WIFI_EVENT_STAMODE_AUTHMODE_CHANGE,
+  WIFI_EVENT_STAMODE_GOT_IP,
+  WIFI_EVENT_STAMODE_DHCP_TIMEOUT,
+  WIFI_EVENT_MAX
+} WiFiEvent_t;
+
+enum WiFiDisconnectReason {
+  WIFI_DISCONNECT_REASON_UNSPECIFIED        = 1,
+  WIFI_DISCONNECT_REASON_AUTH_EXPIRE        = 2,
+  WIFI_DISCONNECT_REASON_AUTH_LEAVE         = 3,
+  WIFI_DISCONNECT_REASON_ASSOC_EXPIRE       = 4,
+  WIFI_DISCONNECT_REASON_ASSOC_LEAVE        = 8,
+  WIFI_DISCONNECT_REASON_4WAY_HANDSHAKE_TIMEOUT = 15,
+  WIFI_DISCONNECT_REASON_BEACON_TIMEOUT     = 200,
+  WIFI_DISCONNECT_REASON_NO_AP_FOUND        = 201,
+  WIFI_DISCONNECT_REASON_AUTH_FAIL          = 202,
+  WIFI_DISCONNECT_REASON_ASSOC_FAIL         = 203,
+  WIFI_DISCONNECT_REASON_HANDSHAKE_TIMEOUT  = 204
+};
+
+struct WiFiEventStationModeConnected    { String ssid; uint8_t bssid[6]; uint8_t channel; };
+struct WiFiEventStationModeDisconnected { String ssid; uint8_t bssid[6]; WiFiDisconnectReason reason; };
+struct WiFiEventStationModeGotIP        { IPAddress ip; IPAddress mask; IPAddress gw; };
+
+// handlers stay registered while the returned handle is held, like the core
+struct WiFiEventHandlerOpaque {
+  WiFiEvent_t event;
+  std::function<void(const void*)> fn;
+};
+typedef std::shared_ptr<WiFiEventHandlerOpaque> WiFiEventHandler;
+
+class ESP8266WiFiClass {
+  public:
+    // generic
+    bool         mode(WiFiMode_t m);
+    WiFiMode_t   getMode();
+    bool         enableSTA(bool enable);
+    bool         enableAP(bool enable);
+    void         persistent(bool persistent);
+    bool         setSleepMode(WiFiSleepType_t type){ _sleep = type; return true; }
+    WiFiSleepType_t getSleepMode(){ return _sleep; }
+    bool         setPhyMode(WiFiPhyMode_t){ return true; }
+    void         setOutputPower(float){}
+    int32_t      channel();
+
+    WiFiEventHandler onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> fn);
+    WiFiEventHandler onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> fn);
+    WiFiEventHandler onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> fn);
+
+    // station
+    wl_status_t  begin(const char *ssid, const char *pass = NULL, int32_t channel = 0, const uint8_t *bssid = NULL, bool connect = true);
+    wl_status_t  begin(const String &ssid, const String &pass = String()){ return begin(ssid.c_str(), pass.c_str()); }
+    wl_status_t  begin();
+    bool         config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1 = IPAddress(), IPAddress dns2 = IPAddress());
+    bool         reconnect();
+    bool         disconnect(bool wifioff = false);
+    bool         isConnected(){ return status() == WL_CONNECTED; }
+    bool         setAutoConnect(bool autoConnect){ _autoConnect = autoConnect; return true; }
+    bool         getAutoConnect(){ return _autoConnect; }
+    bool         setAutoReconnect(bool autoReconnect){ _autoReconnect = autoReconnect; return true; }
+    bool         getAutoReconnect(){ return _autoReconnect; }
+    int8_t       waitForConnectResult(unsigned long timeoutLength = 60000);
+    wl_status_t  status();
+    IPAddress    localIP();
+    IPAddress    subnetMask();
+    IPAddress    gatewayIP();
+    IPAddress    dnsIP(uint8_t dns_no = 0);
+    String       macAddress(){ return F("5C:CF:7F:00:00:01"); }
+    String       SSID() const;
+    String       psk() const;
+    String       BSSIDstr(){ return F("02:00:00:00:00:06"); }
+    int32_t      RSSI();
+    String       hostname(){ return _hostname; }
+    bool         hostname(const char *name){ _hostname = name; return true; }
+    bool         hostname(const String &name){ return hostname(name.c_str()); }
+    bool         beginWPSConfig(){ return false; }
+
+    // softap
+    bool         softAP(const char *ssid, const char *pass = NULL, int channel = 1, int ssid_hidden = 0, int max_connection = 4);
+    bool         softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet);
+    bool         softAPdisconnect(bool wifioff = false);
+    uint8_t      softAPgetStationNum(){ return wifi_softap_get_station_num(); }
+    IPAddress    softAPIP();
+    String       softAPmacAddress(){ return F("5E:CF:7F:00:00:01"); }
+    String       softAPSSID() const;
+    String       softAPPSK() const;
+
+    // scan
+    int8_t       scanNetworks(bool async = false, bool show_hidden = false, uint8_t channel = 0, uint8_t *ssid = NULL);
+    void         scanNetworksAsync(std::function<void(int)> onComplete, bool show_hidden = false);
+    int8_t       scanComplete();
+    void         scanDelete();
+    String       SSID(uint8_t i);
+    int32_t      RSSI(uint8_t i);
+    uint8_t      encryptionType(uint8_t i);
+    int32_t      channel(uint8_t i);
+    uint8_t*     BSSID(uint8_t i){ static uint8_t bssid[6] = {2, 0, 0, 0, 0, 0}; bssid[5] = i; return bssid; }
+    String       BSSIDstr(uint8_t i){ char buf[18]; snprintf(buf, sizeof(buf), "02:00:00:00:00:%02X", i); return String(buf); }
+    bool         isHidden(uint8_t){ return false; }
+
+  private:
+    WiFiSleepType_t _sleep        = WIFI_MODEM_SLEEP;
+    bool            _autoConnect  = true;
+    bool            _autoReconnect= true;
+    String          _hostname     = F("ESP-C0FFEE");
+};
+extern ESP8266WiFiClass WiFi;
+
+#endif
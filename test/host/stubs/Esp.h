@@ -0,0 +1,41 @@
+/**
+ * host EspClass, fixed chip facts, restart is counted and rtc user memory is kept in ram
+ */
+#ifndef WM_HOST_ESP_H
+#define WM_HOST_ESP_H
+
+class EspClass {
+  public:
+    uint32_t getChipId(){ return 0x00C0FFEE; }
+    uint32_t getFlashChipId(){ return 0x001640EF; }
+    uint32_t getFlashChipSize(){ return 4 * 1024 * 1024; }
+    uint32_t getFlashChipRealSize(){ return 4 * 1024 * 1024; }
+    uint32_t getSketchSize(){ return 400 * 1024; }
+    uint32_t getFreeSketchSpace(){ return 1024 * 1024; }
+    uint32_t getFreeHeap(){ return 40 * 1024; }
+    uint8_t  getCpuFreqMHz(){ return 80; }
+    uint32_t getCycleCount(){ return (uint32_t)(micros() * 80UL); }
+    String   getCoreVersion(){ return F("3_1_2"); }
+    const char* getSdkVersion(){ return "2.2.2-dev(host)"; }
+    String   getResetReason(){ return F("External System"); }
+    bool     eraseConfig(){ return true; }
+    bool     flashEraseSector(uint32_t){ return true; }
+    void     restart(){ restarts++; }
+
+    bool rtcUserMemoryRead(uint32_t offset, uint32_t *data, size_t size){
+      if(offset * 4 + size > sizeof(rtc)) return false;
+      memcpy(data, (uint8_t*)rtc + offset * 4, size);
+      return true;
+    }
+    bool rtcUserMemoryWrite(uint32_t offset, uint32_t *data, size_t size){
+      if(offset * 4 + size > sizeof(rtc)) return false;
+      memcpy((uint8_t*)rtc + offset * 4, data, size);
+      return true;
+    }
+
+    uint32_t restarts = 0;
+    uint32_t rtc[128] = {};
+};
+extern EspClass ESP;
+
+#endif
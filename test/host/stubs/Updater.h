@@ -0,0 +1,34 @@
+/**
+ * host Updater, accepts and counts the image, nothing is flashed
+ */
+#ifndef WM_HOST_UPDATER_H
+#define WM_HOST_UPDATER_H
+
+#include "Arduino.h"
+
+#define UPDATE_ERROR_OK 0
+#define UPDATE_SIZE_UNKNOWN 0xFFFFFFFF
+
+class UpdateClass {
+  public:
+    typedef std::function<void(size_t, size_t)> THandlerFunction_Progress;
+    bool    runAsync(bool async){ _async = async; return true; }
+    bool    begin(size_t size){ _size = size; _written = 0; _running = true; return true; }
+    size_t  write(uint8_t *data, size_t len){ _written += len; return len; }
+    bool    end(bool evenIfRemaining = false){ _running = false; return true; }
+    bool    isRunning(){ return _running; }
+    bool    hasError(){ return false; }
+    uint8_t getError(){ return UPDATE_ERROR_OK; }
+    void    printError(Print &out){}
+    void    onProgress(THandlerFunction_Progress fn){}
+    size_t  progress(){ return _written; }
+
+  private:
+    bool    _async   = false;
+    bool    _running = false;
+    size_t  _size    = 0;
+    size_t  _written = 0;
+};
+extern UpdateClass Update;
+
+#endif
@@ -0,0 +1,4 @@
+// host build reports the 3.x core, the http pump reads its webserver internals, see WM_HTTPPUMP_INTERNALS
+#define ARDUINO_ESP8266_MAJOR 3
+#define ARDUINO_ESP8266_MINOR 1
+#define ARDUINO_ESP8266_REVISION 2
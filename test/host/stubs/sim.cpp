@@ -0,0 +1,906 @@
+/**
+ * host simulation, virtual clock and event queue, radio model behind the ESP8266WiFi and sdk stubs,
+ * webserver request queue, and the core globals
+ *
+ * the radio follows the 3.x core and nonos sdk where WiFiManager can see it: station connect states,
+ * disconnect reasons and events, opmode, softap netif start, async scans
+ * the sdk's own reconnect retries after a failed association are not modelled, a failure stays until the next begin
+ */
+#include "sim.h"
+#include "ESP8266WiFi.h"
+#include "ESP8266WebServer.h"
+#include "DNSServer.h"
+#include "Updater.h"
+
+#include <map>
+
+HardwareSerial   Serial;
+EspClass         ESP;
+UpdateClass      Update;
+ESP8266WiFiClass WiFi;
+
+namespace wmsim {
+
+unsigned long yieldUs    = 50;
+bool          serialEcho = getenv("WM_HOST_SERIAL") != nullptr;
+unsigned long serviceUs  = 0;
+uint32_t      dnsPolls   = 0;
+Radio         radio;
+
+namespace {
+
+// clock
+
+struct Event {
+  uint64_t due;
+  uint64_t seq;
+  std::function<void()> fn;
+};
+
+uint64_t           _now  = 0; // us since reset
+unsigned long      _base = 0; // millis() at reset
+uint64_t           _seq  = 0;
+std::vector<Event> _events;
+uint32_t           _rand = 1;
+
+// runs events due by target in order, events may wait themselves, time never moves back
+void advanceUs(uint64_t us){
+  uint64_t target = _now + us;
+  for(;;){
+    size_t next = _events.size();
+    for(size_t i = 0; i < _events.size(); i++){
+      if(_events[i].due > target) continue;
+      if(next == _events.size() || _events[i].due < _events[next].due || (_events[i].due == _events[next].due && _events[i].seq < _events[next].seq)) next = i;
+    }
+    if(next == _events.size()) break;
+    if(_events[next].due > _now) _now = _events[next].due;
+    std::function<void()> fn = std::move(_events[next].fn);
+    _events.erase(_events.begin() + next);
+    fn();
+  }
+  if(target > _now) _now = target;
+}
+
+// radio
+
+struct State {
+  uint8_t        opmode      = STATION_MODE;
+  uint8_t        opmodeSaved = STATION_MODE;
+  bool           persistent  = true;
+  station_config current     = {};
+  station_config saved       = {};
+
+  uint8_t        station     = STATION_IDLE;
+  uint32_t       gen         = 0;    // bumped by begin and disconnect, stale association steps check it
+  bool           associated  = false;
+  int32_t        staChannel  = 0;
+  int32_t        staRssi     = 31;
+  IPAddress      staIP;
+  IPAddress      staticIP, staticGW, staticSN, staticDNS;
+
+  bool           apUp        = false;
+  bool           apDeauthed  = false;
+  uint32_t       apGen       = 0;
+  IPAddress      apConfigIP  = IPAddress(192, 168, 4, 1);
+  IPAddress      apIP;
+  String         apSSID, apPass;
+  int32_t        apChannel   = 1;
+
+  int8_t         scan        = WIFI_SCAN_FAILED;
+  uint32_t       scanGen     = 0;
+  std::vector<AP> results;
+
+  std::vector<std::weak_ptr<WiFiEventHandlerOpaque>> handlers;
+  wifi_country_t country     = {{'C', 'N', 0}, 1, 13, WIFI_COUNTRY_POLICY_AUTO};
+} S;
+
+String cfgString(const uint8_t *buf, size_t size){
+  return String(std::string((const char*)buf, strnlen((const char*)buf, size)));
+}
+
+void cfgSet(station_config &conf, const char *ssid, const char *pass){
+  memset(&conf, 0, sizeof(conf));
+  if(ssid) strncpy((char*)conf.ssid, ssid, sizeof(conf.ssid));
+  if(pass) strncpy((char*)conf.password, pass, sizeof(conf.password));
+}
+
+const AP *findAP(const String &ssid){
+  for(const AP &ap : radio.aps) if(ap.ssid == ssid) return &ap;
+  return nullptr;
+}
+
+void fire(WiFiEvent_t event, const void *data){
+  std::vector<std::shared_ptr<WiFiEventHandlerOpaque>> live;
+  for(auto &h : S.handlers) if(auto p = h.lock()) live.push_back(p);
+  S.handlers.assign(live.begin(), live.end());
+  for(auto &h : live) if(h->event == event) h->fn(data);
+}
+
+void fireDisconnected(uint8_t reason){
+  WiFiEventStationModeDisconnected evt = {};
+  evt.ssid   = cfgString(S.current.ssid, sizeof(S.current.ssid));
+  evt.reason = (WiFiDisconnectReason)reason;
+  radio.reasons.push_back(reason);
+  fire(WIFI_EVENT_STAMODE_DISCONNECTED, &evt);
+}
+
+// association, then dhcp, each step dropped if the station was restarted meanwhile
+void stationConnect(){
+  uint32_t gen = ++S.gen;
+  S.station    = STATION_CONNECTING;
+  S.associated = false;
+  S.staIP      = IPAddress();
+  radio.begins.push_back(elapsedMs());
+  String ssid  = cfgString(S.current.ssid, sizeof(S.current.ssid));
+  String pass  = cfgString(S.current.password, sizeof(S.current.password));
+
+  at(radio.assocMs, [gen, ssid, pass](){
+    if(gen != S.gen || !(S.opmode & STATION_MODE)) return;
+    const AP *ap = findAP(ssid);
+    uint8_t state = STATION_CONNECTING, reason = 0;
+    if(radio.failNext > 0){
+      radio.failNext--;
+      state  = STATION_CONNECT_FAIL;
+      reason = radio.failReason;
+    }
+    else if(!ap){
+      state  = STATION_NO_AP_FOUND;
+      reason = WIFI_DISCONNECT_REASON_NO_AP_FOUND;
+    }
+    else if(ap->pass != pass){
+      state  = STATION_WRONG_PASSWORD;
+      reason = WIFI_DISCONNECT_REASON_AUTH_FAIL;
+    }
+    if(reason){
+      S.station = state;
+      fireDisconnected(reason);
+      return;
+    }
+
+    S.associated = true;
+    S.staChannel = ap->channel;
+    S.staRssi    = ap->rssi;
+    WiFiEventStationModeConnected evt = {};
+    evt.ssid    = ssid;
+    evt.channel = ap->channel;
+    fire(WIFI_EVENT_STAMODE_CONNECTED, &evt);
+
+    at(S.staticIP.isSet() ? 0 : radio.dhcpMs, [gen](){
+      if(gen != S.gen || !S.associated) return;
+      S.station = STATION_GOT_IP;
+      S.staIP   = S.staticIP.isSet() ? S.staticIP : IPAddress(192, 168, 1, 50);
+      WiFiEventStationModeGotIP evt;
+      evt.ip   = S.staIP;
+      evt.mask = IPAddress(255, 255, 255, 0);
+      evt.gw   = IPAddress(192, 168, 1, 1);
+      fire(WIFI_EVENT_STAMODE_GOT_IP, &evt);
+    });
+  });
+}
+
+bool stationDisconnect(uint8_t reason){
+  bool associated = S.associated;
+  S.gen++;
+  S.station    = STATION_IDLE;
+  S.associated = false;
+  S.staIP      = IPAddress();
+  if(associated) fireDisconnected(reason);
+  return true;
+}
+
+void apStart(){
+  if(S.apUp) return;
+  uint32_t gen  = ++S.apGen;
+  S.apUp        = true;
+  S.apDeauthed  = false;
+  S.apIP        = IPAddress();
+  at(radio.apStartMs, [gen](){
+    if(gen == S.apGen && S.apUp) S.apIP = S.apConfigIP;
+  });
+}
+
+void apStop(){
+  S.apGen++;
+  S.apUp = false;
+  S.apIP = IPAddress();
+}
+
+bool setOpmode(uint8_t mode){
+  uint8_t old = S.opmode;
+  S.opmode = mode & STATIONAP_MODE;
+  if((old & STATION_MODE) && !(S.opmode & STATION_MODE)) stationDisconnect(WIFI_DISCONNECT_REASON_ASSOC_LEAVE);
+  if((old & SOFTAP_MODE) && !(S.opmode & SOFTAP_MODE)) apStop();
+  if(!(old & SOFTAP_MODE) && (S.opmode & SOFTAP_MODE)) apStart();
+  return true;
+}
+
+void scanStart(std::function<void(int)> done){
+  radio.scans++;
+  uint32_t gen = ++S.scanGen;
+  S.scan = WIFI_SCAN_RUNNING;
+  S.results.clear();
+  at(radio.scanMs, [gen, done](){
+    if(gen != S.scanGen) return;
+    S.results = radio.aps;
+    S.scan    = (int8_t)S.results.size();
+    if(done) done(S.scan);
+  });
+}
+
+// webserver
+
+std::map<uint16_t, std::deque<Request>> _queues;
+std::map<uint16_t, int>                 _listeners;
+
+} // namespace
+
+void reset(unsigned long startMillis){
+  _now  = 0;
+  _base = startMillis;
+  _seq  = 0;
+  _rand = 1;
+  _events.clear();
+  radio     = Radio();
+  S         = State();
+  serviceUs = 0;
+  dnsPolls  = 0;
+  _queues.clear();
+  _listeners.clear();
+  ESP.restarts = 0;
+}
+
+uint64_t elapsedUs(){
+  return _now;
+}
+
+unsigned long elapsedMs(){
+  return (unsigned long)(_now / 1000);
+}
+
+void at(unsigned long ms, std::function<void()> fn){
+  _events.push_back(Event{_now + (uint64_t)ms * 1000, _seq++, std::move(fn)});
+}
+
+void addAP(const String &ssid, const String &pass, int32_t rssi, int32_t channel){
+  removeAP(ssid);
+  radio.aps.push_back(AP{ssid, pass, rssi, channel});
+}
+
+void removeAP(const String &ssid){
+  for(auto it = radio.aps.begin(); it != radio.aps.end(); ++it){
+    if(it->ssid == ssid){
+      radio.aps.erase(it);
+      return;
+    }
+  }
+}
+
+void saveConfig(const String &ssid, const String &pass, bool connecting){
+  cfgSet(S.saved, ssid.c_str(), pass.c_str());
+  S.current = S.saved;
+  if(connecting && (S.opmode & STATION_MODE)) stationConnect();
+}
+
+void dropLink(uint8_t reason){
+  if(!S.associated) return;
+  stationDisconnect(reason);
+  if(WiFi.getAutoReconnect()) stationConnect();
+}
+
+String savedSSID(){
+  return cfgString(S.saved.ssid, sizeof(S.saved.ssid));
+}
+
+uint8_t stationState(){
+  return S.station;
+}
+
+String Response::header(const String &name) const {
+  for(auto &h : headers) if(h.first.equalsIgnoreCase(name)) return h.second;
+  return String();
+}
+
+ResponseRef request(const String &method, const String &uri, const Pairs &args, const Pairs &headers, uint16_t port){
+  ResponseRef resp = std::make_shared<Response>();
+  resp->queuedMs = elapsedMs();
+  if(!listening(port)){ // refused
+    resp->done = true;
+    return resp;
+  }
+  Request req;
+  req.method   = method;
+  req.uri      = uri;
+  req.args     = args;
+  req.headers  = headers;
+  req.response = resp;
+  _queues[port].push_back(req);
+  return resp;
+}
+
+bool listening(uint16_t port){
+  auto it = _listeners.find(port);
+  return it != _listeners.end() && it->second > 0;
+}
+
+size_t pending(uint16_t port){
+  auto it = _queues.find(port);
+  return it == _queues.end() ? 0 : it->second.size();
+}
+
+std::deque<Request> &queue(uint16_t port){
+  return _queues[port];
+}
+
+void listen(uint16_t port, bool on){
+  int &n = _listeners[port];
+  n += on ? 1 : -1;
+  if(n > 0) return;
+  n = 0;
+  for(Request &req : _queues[port]) req.response->done = true; // reset by the closed listener
+  _queues[port].clear();
+}
+
+} // namespace wmsim
+
+using namespace wmsim;
+
+// arduino
+
+unsigned long millis(){
+  return _base + (unsigned long)(_now / 1000);
+}
+
+unsigned long micros(){
+  return _base * 1000UL + (unsigned long)_now;
+}
+
+void delay(unsigned long ms){
+  if(ms == 0) yield();
+  else advanceUs((uint64_t)ms * 1000);
+}
+
+void delayMicroseconds(unsigned int us){
+  advanceUs(us);
+}
+
+void yield(){
+  advanceUs(yieldUs);
+}
+
+long random(long max){
+  if(max <= 0) return 0;
+  _rand = _rand * 1103515245u + 12345u;
+  return (long)((_rand >> 8) % (uint32_t)max);
+}
+
+long random(long min, long max){
+  return max <= min ? min : min + random(max - min);
+}
+
+void randomSeed(unsigned long seed){
+  _rand = (uint32_t)seed | 1;
+}
+
+size_t HardwareSerial::write(uint8_t c){
+  return write(&c, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buf, size_t n){
+  if(serialEcho) fwrite(buf, 1, n, stderr);
+  return n;
+}
+
+// sdk
+
+extern "C" {
+
+bool wifi_station_get_config(struct station_config *config){
+  *config = S.current;
+  return true;
+}
+
+bool wifi_station_get_config_default(struct station_config *config){
+  *config = S.saved;
+  return true;
+}
+
+bool wifi_station_disconnect(void){
+  if(!(S.opmode & STATION_MODE)) return false;
+  return stationDisconnect(WIFI_DISCONNECT_REASON_ASSOC_LEAVE);
+}
+
+uint8_t wifi_station_get_connect_status(void){
+  return S.station;
+}
+
+uint8_t wifi_softap_get_station_num(void){
+  return (S.apUp && !S.apDeauthed) ? radio.apClients : 0;
+}
+
+bool wifi_softap_get_config(struct softap_config *config){
+  memset(config, 0, sizeof(*config));
+  strncpy((char*)config->ssid, S.apSSID.c_str(), sizeof(config->ssid));
+  strncpy((char*)config->password, S.apPass.c_str(), sizeof(config->password));
+  config->ssid_len       = S.apSSID.length();
+  config->channel        = S.apChannel;
+  config->max_connection = 4;
+  config->beacon_interval= 100;
+  return true;
+}
+
+uint8_t wifi_get_opmode(void){
+  return S.opmode;
+}
+
+bool wifi_set_opmode(uint8_t opmode){
+  S.opmodeSaved = opmode;
+  return setOpmode(opmode);
+}
+
+bool wifi_set_opmode_current(uint8_t opmode){
+  return setOpmode(opmode);
+}
+
+bool wifi_get_country(wifi_country_t *country){
+  *country = S.country;
+  return true;
+}
+
+bool wifi_set_country(wifi_country_t *country){
+  S.country = *country;
+  return true;
+}
+
+bool wifi_get_ip_info(uint8_t if_index, struct ip_info *info){
+  info->ip      = if_index == SOFTAP_IF ? (uint32_t)S.apIP : (uint32_t)S.staIP;
+  info->netmask = IPAddress(255, 255, 255, 0);
+  info->gw      = if_index == SOFTAP_IF ? (uint32_t)S.apIP : (uint32_t)IPAddress(192, 168, 1, 1);
+  return true;
+}
+
+void system_print_meminfo(void){}
+
+const char* system_get_sdk_version(void){
+  return ESP.getSdkVersion();
+}
+
+uint8_t system_get_boot_version(void){
+  return 31;
+}
+
+} // extern "C"
+
+// ESP8266WiFi
+
+bool ESP8266WiFiClass::mode(WiFiMode_t m){
+  if(S.persistent){
+    if(S.opmode == m && S.opmodeSaved == m) return true;
+    return wifi_set_opmode(m);
+  }
+  if(S.opmode == m) return true;
+  return wifi_set_opmode_current(m);
+}
+
+WiFiMode_t ESP8266WiFiClass::getMode(){
+  return (WiFiMode_t)S.opmode;
+}
+
+bool ESP8266WiFiClass::enableSTA(bool enable){
+  WiFiMode_t m = getMode();
+  return mode((WiFiMode_t)(enable ? (m | WIFI_STA) : (m & ~WIFI_STA)));
+}
+
+bool ESP8266WiFiClass::enableAP(bool enable){
+  WiFiMode_t m = getMode();
+  return mode((WiFiMode_t)(enable ? (m | WIFI_AP) : (m & ~WIFI_AP)));
+}
+
+void ESP8266WiFiClass::persistent(bool persistent){
+  S.persistent = persistent;
+}
+
+int32_t ESP8266WiFiClass::channel(){
+  if(S.associated) return S.staChannel;
+  return S.apUp ? S.apChannel : 1;
+}
+
+static WiFiEventHandler addHandler(WiFiEvent_t event, std::function<void(const void*)> fn){
+  WiFiEventHandler handler = std::make_shared<WiFiEventHandlerOpaque>();
+  handler->event = event;
+  handler->fn    = fn;
+  S.handlers.push_back(handler);
+  return handler;
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeConnected(std::function<void(const WiFiEventStationModeConnected&)> fn){
+  return addHandler(WIFI_EVENT_STAMODE_CONNECTED, [fn](const void *evt){ fn(*static_cast<const WiFiEventStationModeConnected*>(evt)); });
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeDisconnected(std::function<void(const WiFiEventStationModeDisconnected&)> fn){
+  return addHandler(WIFI_EVENT_STAMODE_DISCONNECTED, [fn](const void *evt){ fn(*static_cast<const WiFiEventStationModeDisconnected*>(evt)); });
+}
+
+WiFiEventHandler ESP8266WiFiClass::onStationModeGotIP(std::function<void(const WiFiEventStationModeGotIP&)> fn){
+  return addHandler(WIFI_EVENT_STAMODE_GOT_IP, [fn](const void *evt){ fn(*static_cast<const WiFiEventStationModeGotIP*>(evt)); });
+}
+
+wl_status_t ESP8266WiFiClass::begin(const char *ssid, const char *pass, int32_t channel, const uint8_t *bssid, bool connect){
+  if(!enableSTA(true)) return WL_CONNECT_FAILED;
+  if(!ssid || !*ssid || strlen(ssid) > 32) return WL_CONNECT_FAILED;
+  if(pass && strlen(pass) > 64) return WL_CONNECT_FAILED;
+  stationDisconnect(WIFI_DISCONNECT_REASON_ASSOC_LEAVE); // new config restarts the station
+  cfgSet(S.current, ssid, pass);
+  if(S.persistent) S.saved = S.current;
+  if(connect) stationConnect();
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::begin(){
+  if(!enableSTA(true)) return WL_CONNECT_FAILED;
+  stationConnect();
+  return status();
+}
+
+bool ESP8266WiFiClass::config(IPAddress local, IPAddress gateway, IPAddress subnet, IPAddress dns1, IPAddress dns2){
+  S.staticIP  = local;
+  S.staticGW  = gateway;
+  S.staticSN  = subnet;
+  S.staticDNS = dns1;
+  if(S.station == STATION_GOT_IP && local.isSet()) S.staIP = local;
+  return true;
+}
+
+bool ESP8266WiFiClass::reconnect(){
+  if(!(S.opmode & STATION_MODE)) return false;
+  stationDisconnect(WIFI_DISCONNECT_REASON_ASSOC_LEAVE);
+  stationConnect();
+  return true;
+}
+
+bool ESP8266WiFiClass::disconnect(bool wifioff){
+  if(!(S.opmode & STATION_MODE)) return false;
+  memset(&S.current, 0, sizeof(S.current));
+  if(S.persistent) S.saved = S.current;
+  bool ret = wifi_station_disconnect();
+  if(wifioff) enableSTA(false);
+  return ret;
+}
+
+int8_t ESP8266WiFiClass::waitForConnectResult(unsigned long timeoutLength){
+  if(!(S.opmode & STATION_MODE)) return WL_DISCONNECTED;
+  unsigned long start = millis();
+  while(status() == WL_DISCONNECTED && millis() - start < timeoutLength) delay(100);
+  return status();
+}
+
+wl_status_t ESP8266WiFiClass::status(){
+  switch(S.station){
+    case STATION_GOT_IP:         return WL_CONNECTED;
+    case STATION_NO_AP_FOUND:    return WL_NO_SSID_AVAIL;
+    case STATION_CONNECT_FAIL:   return WL_CONNECT_FAILED;
+    case STATION_WRONG_PASSWORD: return WL_WRONG_PASSWORD;
+    case STATION_IDLE:           return WL_IDLE_STATUS;
+    default:                     return WL_DISCONNECTED;
+  }
+}
+
+IPAddress ESP8266WiFiClass::localIP(){
+  return S.staIP;
+}
+
+IPAddress ESP8266WiFiClass::subnetMask(){
+  return S.staIP.isSet() ? (S.staticSN.isSet() ? S.staticSN : IPAddress(255, 255, 255, 0)) : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::gatewayIP(){
+  return S.staIP.isSet() ? (S.staticGW.isSet() ? S.staticGW : IPAddress(192, 168, 1, 1)) : IPAddress();
+}
+
+IPAddress ESP8266WiFiClass::dnsIP(uint8_t dns_no){
+  return S.staIP.isSet() ? (S.staticDNS.isSet() ? S.staticDNS : IPAddress(192, 168, 1, 1)) : IPAddress();
+}
+
+String ESP8266WiFiClass::SSID() const {
+  return cfgString(S.current.ssid, sizeof(S.current.ssid));
+}
+
+String ESP8266WiFiClass::psk() const {
+  return cfgString(S.current.password, sizeof(S.current.password));
+}
+
+int32_t ESP8266WiFiClass::RSSI(){
+  return S.associated ? S.staRssi : 31;
+}
+
+bool ESP8266WiFiClass::softAP(const char *ssid, const char *pass, int channel, int ssid_hidden, int max_connection){
+  if(radio.apFail || !ssid || !*ssid) return false;
+  if(pass && *pass && strlen(pass) < 8) return false;
+  if(!enableAP(true)) return false;
+  S.apSSID     = ssid;
+  S.apPass     = pass ? pass : "";
+  S.apChannel  = channel;
+  S.apDeauthed = false;
+  return true;
+}
+
+bool ESP8266WiFiClass::softAPConfig(IPAddress local, IPAddress gateway, IPAddress subnet){
+  S.apConfigIP = local;
+  if(S.apIP.isSet()) S.apIP = local;
+  return true;
+}
+
+bool ESP8266WiFiClass::softAPdisconnect(bool wifioff){
+  S.apSSID = "";
+  S.apPass = "";
+  uint32_t gen = S.apGen;
+  at(radio.apStopMs, [gen](){ if(gen == S.apGen) S.apDeauthed = true; });
+  if(wifioff) return enableAP(false);
+  return true;
+}
+
+IPAddress ESP8266WiFiClass::softAPIP(){
+  return S.apIP;
+}
+
+String ESP8266WiFiClass::softAPSSID() const {
+  return S.apSSID;
+}
+
+String ESP8266WiFiClass::softAPPSK() const {
+  return S.apPass;
+}
+
+int8_t ESP8266WiFiClass::scanNetworks(bool async, bool show_hidden, uint8_t channel, uint8_t *ssid){
+  if(S.scan == WIFI_SCAN_RUNNING) return WIFI_SCAN_RUNNING;
+  enableSTA(true);
+  scanStart(nullptr);
+  if(async) return WIFI_SCAN_RUNNING;
+  while(S.scan == WIFI_SCAN_RUNNING) delay(10); // the core suspends until the sdk scan callback
+  return S.scan;
+}
+
+void ESP8266WiFiClass::scanNetworksAsync(std::function<void(int)> onComplete, bool show_hidden){
+  if(S.scan == WIFI_SCAN_RUNNING) return;
+  enableSTA(true);
+  scanStart(onComplete);
+}
+
+int8_t ESP8266WiFiClass::scanComplete(){
+  return S.scan;
+}
+
+void ESP8266WiFiClass::scanDelete(){
+  S.scanGen++;
+  S.scan = WIFI_SCAN_FAILED;
+  S.results.clear();
+}
+
+String ESP8266WiFiClass::SSID(uint8_t i){
+  return i < S.results.size() ? S.results[i].ssid : String();
+}
+
+int32_t ESP8266WiFiClass::RSSI(uint8_t i){
+  return i < S.results.size() ? S.results[i].rssi : 0;
+}
+
+uint8_t ESP8266WiFiClass::encryptionType(uint8_t i){
+  if(i >= S.results.size()) return 255;
+  return S.results[i].pass == "" ? ENC_TYPE_NONE : ENC_TYPE_CCMP;
+}
+
+int32_t ESP8266WiFiClass::channel(uint8_t i){
+  return i < S.results.size() ? S.results[i].channel : 0;
+}
+
+// WiFiClient
+
+size_t WiFiClient::write(const uint8_t *buf, size_t n){
+  if(!_resp || _resp->ended) return 0;
+  _resp->raw = true;
+  _resp->body.append((const char*)buf, n);
+  return n;
+}
+
+void WiFiClient::stop(){
+  if(_resp) _resp->ended = true;
+}
+
+// ESP8266WebServer
+
+namespace {
+
+class FunctionRequestHandler : public RequestHandler {
+  public:
+    FunctionRequestHandler(ESP8266WebServer::THandlerFunction fn, ESP8266WebServer::THandlerFunction ufn, const Uri &uri, HTTPMethod method)
+      : _fn(fn), _ufn(ufn), _uri(uri.str()), _method(method) {}
+    bool canHandle(HTTPMethod method, const String &uri) override { return (_method == HTTP_ANY || _method == method) && uri == _uri; }
+    bool canUpload(const String &uri) override { return _ufn && uri == _uri; }
+    bool handle(ESP8266WebServer &server, HTTPMethod method, const String &uri) override {
+      if(!canHandle(method, uri)) return false;
+      _fn();
+      return true;
+    }
+    void upload(ESP8266WebServer &server, const String &uri, HTTPUpload &upload) override { if(canUpload(uri)) _ufn(); }
+
+  private:
+    ESP8266WebServer::THandlerFunction _fn, _ufn;
+    String     _uri;
+    HTTPMethod _method;
+};
+
+HTTPMethod parseMethod(const String &method){
+  if(method == "POST")    return HTTP_POST;
+  if(method == "HEAD")    return HTTP_HEAD;
+  if(method == "PUT")     return HTTP_PUT;
+  if(method == "PATCH")   return HTTP_PATCH;
+  if(method == "DELETE")  return HTTP_DELETE;
+  if(method == "OPTIONS") return HTTP_OPTIONS;
+  return HTTP_GET;
+}
+
+const String _empty;
+
+// prebuilt responses written straight to the client, split into status, headers and body
+void parseRaw(wmsim::Response &resp){
+  size_t head = resp.body.find("\r\n\r\n");
+  if(resp.body.compare(0, 5, "HTTP/") != 0 || head == std::string::npos) return;
+  std::string lines = resp.body.substr(0, head + 2);
+  resp.code = atoi(lines.c_str() + lines.find(' ') + 1);
+  for(size_t at = lines.find("\r\n") + 2, end; (end = lines.find("\r\n", at)) != std::string::npos; at = end + 2){
+    std::string line = lines.substr(at, end - at);
+    size_t colon = line.find(':');
+    if(colon == std::string::npos) continue;
+    size_t value = line.find_first_not_of(' ', colon + 1);
+    resp.headers.push_back(std::make_pair(String(line.substr(0, colon)), String(value == std::string::npos ? std::string() : line.substr(value))));
+  }
+  resp.body.erase(0, head + 4);
+}
+
+const String &lookup(const wmsim::Pairs &pairs, const String &name){
+  for(auto &p : pairs) if(p.first.equalsIgnoreCase(name)) return p.second;
+  return _empty;
+}
+
+} // namespace
+
+ESP8266WebServer::~ESP8266WebServer(){
+  *_alive = false;
+  close();
+  for(RequestHandler *h = _firstHandler; h;){
+    RequestHandler *next = h->next();
+    delete h;
+    h = next;
+  }
+}
+
+// one request per call, a handler may delete this server, nothing here touches members after dispatch then
+void ESP8266WebServer::handleClient(){
+  if(!_server.listening() || wmsim::pending(_server.port()) == 0) return;
+  std::deque<wmsim::Request> &q = wmsim::queue(_server.port());
+  _req = q.front();
+  q.pop_front();
+  _method = parseMethod(_req.method);
+  for(auto &h : _collected) h.second = lookup(_req.headers, h.first);
+  _pendingHeaders.clear();
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  _chunked       = false;
+  wmsim::ResponseRef resp = _req.response;
+  IPAddress local = WiFi.softAPIP().isSet() ? WiFi.softAPIP() : WiFi.localIP();
+  _currentClient = WiFiClient(resp, local);
+  _currentStatus = HC_WAIT_READ;
+  _statusChange  = millis();
+  if(wmsim::serviceUs) delayMicroseconds(wmsim::serviceUs);
+
+  RequestHandler *handler = _firstHandler;
+  while(handler && !handler->canHandle(_method, _req.uri)) handler = handler->next();
+  std::shared_ptr<bool> alive = _alive;
+  bool handled = handler && handler->handle(*this, _method, _req.uri);
+  if(*alive){
+    if(!handled && _notFound) _notFound();
+    else if(!handled) send(404, "text/plain", String("Not found: ") + _req.uri);
+    if(_chunked) sendContent(String());
+    _currentClient = WiFiClient();
+    _currentStatus = HC_NONE;
+    _statusChange  = millis();
+  }
+  if(resp->raw && !resp->code) parseRaw(*resp);
+  if(!resp->chunked && !resp->raw && resp->code) resp->ended = true;
+  resp->done     = true;
+  resp->servedMs = wmsim::elapsedMs();
+}
+
+void ESP8266WebServer::on(const Uri &uri, HTTPMethod method, THandlerFunction fn, THandlerFunction ufn){
+  addHandler(new FunctionRequestHandler(fn, ufn, uri, method));
+}
+
+void ESP8266WebServer::addHandler(RequestHandler *handler){
+  if(!_lastHandler) _firstHandler = handler;
+  else _lastHandler->next(handler);
+  _lastHandler = handler;
+}
+
+bool ESP8266WebServer::removeHandler(RequestHandler *handler){
+  RequestHandler *prev = nullptr;
+  for(RequestHandler *h = _firstHandler; h; prev = h, h = h->next()){
+    if(h != handler) continue;
+    if(prev) prev->next(h->next());
+    else _firstHandler = h->next();
+    if(_lastHandler == h) _lastHandler = prev;
+    h->next(nullptr);
+    return true;
+  }
+  return false;
+}
+
+const String& ESP8266WebServer::arg(const String &name) const {
+  return lookup(_req.args, name);
+}
+
+const String& ESP8266WebServer::arg(int i) const {
+  return i >= 0 && i < (int)_req.args.size() ? _req.args[i].second : _empty;
+}
+
+const String& ESP8266WebServer::argName(int i) const {
+  return i >= 0 && i < (int)_req.args.size() ? _req.args[i].first : _empty;
+}
+
+bool ESP8266WebServer::hasArg(const String &name) const {
+  for(auto &a : _req.args) if(a.first == name) return true;
+  return false;
+}
+
+void ESP8266WebServer::collectHeaders(const char *headerKeys[], const size_t headerKeysCount){
+  _collected.clear();
+  for(size_t i = 0; i < headerKeysCount; i++) _collected.push_back(std::make_pair(String(headerKeys[i]), String()));
+}
+
+const String& ESP8266WebServer::header(const String &name) const {
+  return lookup(_collected, name);
+}
+
+const String& ESP8266WebServer::header(int i) const {
+  return i >= 0 && i < (int)_collected.size() ? _collected[i].second : _empty;
+}
+
+const String& ESP8266WebServer::headerName(int i) const {
+  return i >= 0 && i < (int)_collected.size() ? _collected[i].first : _empty;
+}
+
+bool ESP8266WebServer::hasHeader(const String &name) const {
+  return header(name).length() > 0;
+}
+
+const String& ESP8266WebServer::hostHeader() const {
+  return lookup(_req.headers, "Host");
+}
+
+void ESP8266WebServer::send(int code, const char *content_type, const String &content){
+  wmsim::ResponseRef resp = _req.response;
+  if(!resp || resp->code) return; // one status line per request
+  resp->code    = code;
+  resp->type    = content_type ? content_type : "";
+  resp->headers = _pendingHeaders;
+  _pendingHeaders.clear();
+  if(_contentLength == CONTENT_LENGTH_UNKNOWN){
+    _chunked      = true;
+    resp->chunked = true;
+  }
+  _contentLength = CONTENT_LENGTH_NOT_SET;
+  resp->body += content.str();
+}
+
+void ESP8266WebServer::sendHeader(const String &name, const String &value, bool first){
+  if(first) _pendingHeaders.insert(_pendingHeaders.begin(), std::make_pair(name, value));
+  else _pendingHeaders.push_back(std::make_pair(name, value));
+}
+
+void ESP8266WebServer::sendContent(const char *content, size_t size){
+  wmsim::ResponseRef resp = _req.response;
+  if(!resp || resp->ended) return;
+  if(_chunked && size == 0){
+    resp->ended = true;
+    _chunked    = false;
+    return;
+  }
+  resp->body.append(content, size);
+}
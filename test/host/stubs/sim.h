@@ -0,0 +1,104 @@
+/**
+ * host simulation behind the stub cores, virtual clock, radio model, webserver request queue and dns
+ * tests drive WiFiManager through its public api and steer the simulation from here
+ *
+ * time only moves in delay(), delayMicroseconds() and yield(), radio and test events run as it passes their due time
+ * unsigned long is 64 bit on the host, millis() rolls over at its width like the 32 bit cores do at theirs
+ */
+#ifndef WM_HOST_SIM_H
+#define WM_HOST_SIM_H
+
+#include "Arduino.h"
+#include <memory>
+#include <vector>
+#include <deque>
+#include <utility>
+
+namespace wmsim {
+
+// clock
+
+void          reset(unsigned long startMillis = 0); // clock, radio, webserver and dns back to power on
+uint64_t      elapsedUs();                           // virtual us since reset, never rolls over
+unsigned long elapsedMs();
+void          at(unsigned long ms, std::function<void()> fn); // run fn ms from now, from whatever is waiting
+extern unsigned long yieldUs;  // cost of one yield(), a loop spinning on yield still moves time
+extern bool   serialEcho;      // Serial to stderr, also set by WM_HOST_SERIAL=1
+
+// radio
+
+struct AP {
+  String  ssid;
+  String  pass;
+  int32_t rssi;
+  int32_t channel;
+};
+
+struct Radio {
+  unsigned long scanMs    = 2200; // active scan over all channels
+  unsigned long assocMs   = 900;  // begin to associated
+  unsigned long dhcpMs    = 300;  // associated to got ip
+  unsigned long apStartMs = 30;   // softap netif up
+  unsigned long apStopMs  = 100;  // softap deauths its clients
+  uint8_t       failNext  = 0;    // next associations fail with failReason, ap or not
+  uint8_t       failReason= 2;    // WIFI_DISCONNECT_REASON_AUTH_EXPIRE
+  uint8_t       apClients = 0;    // stations on the softap while it is up
+  bool          apFail    = false;// softAP() refuses to start
+
+  std::vector<AP>            aps;
+  std::vector<unsigned long> begins;  // elapsedMs() of every begin, stored config or new
+  std::vector<uint8_t>       reasons; // disconnect reasons handed to event handlers
+  uint32_t                   scans = 0;
+};
+extern Radio radio;
+
+void    addAP(const String &ssid, const String &pass, int32_t rssi = -55, int32_t channel = 6);
+void    removeAP(const String &ssid);
+void    saveConfig(const String &ssid, const String &pass, bool connecting = false); // flash config, connecting as the sdk does at boot
+void    dropLink(uint8_t reason = 200); // connected station loses the ap, WIFI_DISCONNECT_REASON_BEACON_TIMEOUT
+String  savedSSID();
+uint8_t stationState(); // STATION_*
+
+// webserver
+
+typedef std::vector<std::pair<String, String>> Pairs;
+
+struct Response {
+  bool          done    = false; // handled by a server
+  int           code    = 0;
+  String        type;
+  Pairs         headers;
+  std::string   body;             // chunk framing removed
+  bool          chunked = false;
+  bool          ended   = false;  // complete, sized body or last chunk sent
+  bool          raw     = false;  // written straight to the client
+  unsigned long queuedMs = 0;
+  unsigned long servedMs = 0;
+  String header(const String &name) const;
+};
+typedef std::shared_ptr<Response> ResponseRef;
+
+struct Request {
+  String      method;
+  String      uri;
+  Pairs       args;
+  Pairs       headers;
+  ResponseRef response;
+};
+
+ResponseRef request(const String &method, const String &uri, const Pairs &args = Pairs(), const Pairs &headers = Pairs(), uint16_t port = 80);
+bool        listening(uint16_t port = 80);
+size_t      pending(uint16_t port = 80);
+extern unsigned long serviceUs; // virtual cost of parsing and answering one request
+
+// dns
+
+extern uint32_t dnsPolls;
+
+// stub side, not for tests
+std::deque<Request> &queue(uint16_t port);
+void listen(uint16_t port, bool on);
+
+} // namespace wmsim
+
+#endif
@@ -0,0 +1,74 @@
+/**
+ * host nonos sdk surface, backed by the simulated radio in sim.cpp
+ */
+#ifndef WM_HOST_USER_INTERFACE_H
+#define WM_HOST_USER_INTERFACE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint8_t uint8;
+
+#define STATION_IF 0x00
+#define SOFTAP_IF  0x01
+
+#define NULL_MODE       0x00
+#define STATION_MODE    0x01
+#define SOFTAP_MODE     0x02
+#define STATIONAP_MODE  0x03
+
+enum { STATION_IDLE = 0, STATION_CONNECTING, STATION_WRONG_PASSWORD, STATION_NO_AP_FOUND, STATION_CONNECT_FAIL, STATION_GOT_IP };
+
+struct station_config {
+  uint8_t ssid[32];
+  uint8_t password[64];
+  uint8_t bssid_set;
+  uint8_t bssid[6];
+};
+
+struct softap_config {
+  uint8_t  ssid[32];
+  uint8_t  password[64];
+  uint8_t  ssid_len;
+  uint8_t  channel;
+  int      authmode;
+  uint8_t  ssid_hidden;
+  uint8_t  max_connection;
+  uint16_t beacon_interval;
+};
+
+#define WIFI_COUNTRY_POLICY_AUTO   0
+#define WIFI_COUNTRY_POLICY_MANUAL 1
+typedef struct {
+  char    cc[3];
+  uint8_t schan;
+  uint8_t nchan;
+  uint8_t policy;
+} wifi_country_t;
+
+struct ip_info {
+  uint32_t ip;
+  uint32_t netmask;
+  uint32_t gw;
+};
+
+bool    wifi_station_get_config(struct station_config *config);
+bool    wifi_station_get_config_default(struct station_config *config);
+bool    wifi_station_disconnect(void);
+uint8_t wifi_station_get_connect_status(void);
+uint8_t wifi_softap_get_station_num(void);
+bool    wifi_softap_get_config(struct softap_config *config);
+uint8_t wifi_get_opmode(void);
+bool    wifi_set_opmode(uint8_t opmode);
+bool    wifi_set_opmode_current(uint8_t opmode);
+bool    wifi_get_country(wifi_country_t *country);
+bool    wifi_set_country(wifi_country_t *country);
+bool    wifi_get_ip_info(uint8_t if_index, struct ip_info *info);
+void    system_print_meminfo(void);
+const char* system_get_sdk_version(void);
+uint8_t system_get_boot_version(void);
+
+#define ETS_UART_INTR_DISABLE()
+#define ETS_UART_INTR_ENABLE()
+
+#endif
@@ -0,0 +1,72 @@
+/**
+ * host test helpers, each test_*.cpp is one executable, TEST bodies run in order after a sim reset
+ * exit status is the number of failed checks
+ */
+#ifndef WM_HOST_TEST_H
+#define WM_HOST_TEST_H
+
+#include <WiFiManager.h>
+#include <vector>
+
+namespace wmtest {
+
+struct Case {
+  const char *name;
+  void (*fn)();
+};
+
+inline std::vector<Case> &cases(){ static std::vector<Case> c; return c; }
+inline int &failures(){ static int n = 0; return n; }
+
+struct Reg {
+  Reg(const char *name, void (*fn)()){ cases().push_back(Case{name, fn}); }
+};
+
+// sketch loop, process() every step ms until ms have passed or done() holds
+template<typename D>
+inline bool loopUntil(WiFiManager &wm, unsigned long ms, D done, unsigned long step = 10){
+  unsigned long start = wmsim::elapsedMs();
+  while(wmsim::elapsedMs() - start < ms){
+    wm.process();
+    if(done()) return true;
+    delay(step);
+  }
+  return done();
+}
+
+inline void loopFor(WiFiManager &wm, unsigned long ms, unsigned long step = 10){
+  loopUntil(wm, ms, []{ return false; }, step);
+}
+
+} // namespace wmtest
+
+#define TEST(name) \
+  static void name(); \
+  static wmtest::Reg name##_reg(#name, name); \
+  static void name()
+
+#define CHECK(cond) do { \
+  if(!(cond)){ fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); wmtest::failures()++; } \
+} while(0)
+
+#define CHECK_EQ(a, b) do { \
+  long long _a = (long long)(a), _b = (long long)(b); \
+  if(_a != _b){ fprintf(stderr, "%s:%d: CHECK_EQ(%s, %s) failed, %lld != %lld\n", __FILE__, __LINE__, #a, #b, _a, _b); wmtest::failures()++; } \
+} while(0)
+
+#define CHECK_RANGE(v, lo, hi) do { \
+  long long _v = (long long)(v), _lo = (long long)(lo), _hi = (long long)(hi); \
+  if(_v < _lo || _v > _hi){ fprintf(stderr, "%s:%d: CHECK_RANGE(%s) failed, %lld not in [%lld, %lld]\n", __FILE__, __LINE__, #v, _v, _lo, _hi); wmtest::failures()++; } \
+} while(0)
+
+int main(){
+  for(const wmtest::Case &c : wmtest::cases()){
+    int before = wmtest::failures();
+    wmsim::reset();
+    c.fn();
+    printf("%s %s\n", wmtest::failures() == before ? "ok  " : "FAIL", c.name);
+  }
+  return wmtest::failures() > 255 ? 255 : wmtest::failures();
+}
+
+#endif
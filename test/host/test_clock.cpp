@@ -0,0 +1,101 @@
+/**
+ * setClock and setWiFiSim, timeouts and connects driven without the radio, and the radio model itself
+ */
+#include "test.h"
+
+namespace {
+
+unsigned long now;
+unsigned long vclock(){ return now; }
+void vwait(unsigned long ms){ now += ms; delay(ms); } // the radio still runs on the sim clock
+
+} // namespace
+
+TEST(connect_timeout_on_custom_clock){
+  wmsim::saveConfig("home", "secret123");
+  WiFiManager wm;
+  int begins = 0;
+  wm.setClock([]{ return ULONG_MAX - 2000 + wmsim::elapsedMs(); }); // no delayfunc, waits add to the clock
+  wm.setWiFiSim([]{ return (uint8_t)WL_DISCONNECTED; }, [&](const char*, const char*){ begins++; return true; });
+  wm.setConnectTimeout(5);
+  wm.setEnableConfigPortal(false);
+
+  CHECK(!wm.autoConnect("wm-test"));
+  CHECK(begins >= 1);
+  CHECK_EQ(wmsim::radio.begins.size(), 0); // the radio never saw a begin
+  CHECK(wmsim::elapsedMs() < 1000);         // timed out on waited time, not on the sim clock
+  WiFiManager::wm_conntiming_t t = wm.getConnectTiming();
+  CHECK_RANGE(t.total, 5000, 5200);
+}
+
+TEST(portal_timeout_on_custom_clock){
+  now = ULONG_MAX - 10000;
+  WiFiManager wm;
+  wm.setClock(vclock, vwait);
+  wm.setConfigPortalBlocking(false);
+  wm.setConfigPortalTimeout(30);
+  CHECK(!wm.autoConnect("wm-test"));
+
+  for(int i = 0; i < 29; i++){
+    now += 1000;
+    wm.process();
+  }
+  CHECK(wm.getConfigPortalActive());
+  CHECK(now < 30000); // past rollover
+  now += 2000;
+  wm.process();
+  CHECK(!wm.getConfigPortalActive());
+}
+
+TEST(save_on_simulated_status){
+  now = 0;
+  WiFiManager wm;
+  unsigned long connectAt = 0;
+  wm.setClock(vclock, vwait);
+  wm.setWiFiSim([&]{ return (uint8_t)(connectAt && now >= connectAt ? WL_CONNECTED : WL_DISCONNECTED); },
+                [&](const char*, const char*){ connectAt = now + 1500; return true; });
+  wm.setConfigPortalBlocking(false);
+  wm.setCaptivePortalEnable(false);
+  wm.setPortalEvents(true);
+  CHECK(!wm.autoConnect("wm-test"));
+
+  wmsim::request("POST", "/wifisave", {{"s", "home"}, {"p", "secret123"}}, {{"Host", "192.168.4.1"}});
+  bool done = false;
+  for(int i = 0; i < 40 && !done; i++){
+    done = wm.process();
+    now += 100;
+  }
+  CHECK(done);
+  CHECK(connectAt > 0);
+  CHECK_EQ(wmsim::radio.begins.size(), 0);
+}
+
+TEST(radio_latency){
+  wmsim::addAP("home", "secret123");
+  wmsim::saveConfig("home", "secret123");
+  WiFiManager wm;
+  CHECK(wm.autoConnect("wm-test"));
+  WiFiManager::wm_conntiming_t t = wm.getConnectTiming();
+  CHECK_EQ(t.connected, wmsim::radio.assocMs);
+  CHECK_EQ(t.gotip, wmsim::radio.assocMs + wmsim::radio.dhcpMs);
+
+  unsigned long start = wmsim::elapsedMs();
+  CHECK_EQ(WiFi.scanNetworks(), 1);
+  CHECK_EQ(wmsim::elapsedMs() - start, wmsim::radio.scanMs);
+}
+
+TEST(radio_failure_injection){
+  wmsim::addAP("home", "secret123");
+  wmsim::saveConfig("home", "secret123");
+  wmsim::radio.failNext = 2;
+  WiFiManager wm;
+  wm.setConnectRetries(3);
+  wm.setConnectTimeout(10);
+  wm.setEnableConfigPortal(false);
+  CHECK(wm.autoConnect("wm-test"));
+  CHECK_EQ(wmsim::radio.begins.size(), 3);
+  CHECK_EQ(wm.getConnectTiming(1).reason, wmsim::radio.failReason);
+
+  // a failed association ends the attempt when the sdk reports it, not at the timeout
+  CHECK_RANGE(wmsim::radio.begins[1] - wmsim::radio.begins[0], wmsim::radio.assocMs, wmsim::radio.assocMs + 1000);
+}
@@ -0,0 +1,128 @@
+/**
+ * gzip portal pages, encoder output inflated with zlib and compared to the plain page
+ * without zlib only the gzip framing and trailer length are checked
+ */
+#include "test.h"
+#include <string>
+
+#ifdef WM_HOST_ZLIB
+#include <zlib.h>
+#endif
+
+namespace {
+
+const wmsim::Pairs host = {{"Host", "192.168.4.1"}};
+const wmsim::Pairs gzip = {{"Host", "192.168.4.1"}, {"Accept-Encoding", "deflate, gzip;q=1.0, br"}};
+
+bool gunzip(const std::string &in, std::string &out){
+  // member header, fixed 10 bytes with no optional fields from this encoder
+  if(in.size() < 18 || (uint8_t)in[0] != 0x1f || (uint8_t)in[1] != 0x8b || in[2] != 8) return false;
+  const uint8_t *t = (const uint8_t*)in.data() + in.size() - 4;
+  uint32_t isize = t[0] | (t[1] << 8) | (t[2] << 16) | ((uint32_t)t[3] << 24);
+#ifdef WM_HOST_ZLIB
+  z_stream z = {};
+  if(inflateInit2(&z, 16 + 15) != Z_OK) return false;
+  out.assign(isize + 1, '\0');
+  z.next_in   = (Bytef*)in.data();
+  z.avail_in  = in.size();
+  z.next_out  = (Bytef*)&out[0];
+  z.avail_out = out.size();
+  int res = inflate(&z, Z_FINISH); // checks the crc and length trailer
+  out.resize(z.total_out);
+  inflateEnd(&z);
+  return res == Z_STREAM_END && z.total_out == isize;
+#else
+  out.assign(isize, '\0'); // length only
+  return true;
+#endif
+}
+
+std::string encode(const std::string &in, size_t piece){
+  std::string out;
+  WiFiManagerDeflate d([&](const uint8_t *data, size_t len){ out.append((const char*)data, len); });
+  for(size_t i = 0; i < in.size(); i += piece){
+    d.write((const uint8_t*)in.data() + i, std::min(piece, in.size() - i));
+  }
+  d.finish();
+  CHECK_EQ(d.totalIn(), in.size());
+  CHECK_EQ(d.totalOut(), out.size());
+  return out;
+}
+
+void roundtrip(const std::string &in, size_t piece){
+  std::string z = encode(in, piece), back;
+  CHECK(gunzip(z, back));
+  CHECK_EQ(back.size(), in.size());
+#ifdef WM_HOST_ZLIB
+  CHECK(back == in);
+#endif
+}
+
+wmsim::ResponseRef serve(WiFiManager &wm, const String &uri, const wmsim::Pairs &headers){
+  wmsim::ResponseRef r = wmsim::request("GET", uri, {}, headers);
+  wmtest::loopUntil(wm, 5000, [&]{ return r->ended; });
+  return r;
+}
+
+} // namespace
+
+TEST(encoder_roundtrip){
+  roundtrip("", 1);
+  roundtrip("a", 1);
+  roundtrip(std::string(5000, 'x'), 7);  // long runs, overlapping matches
+
+  std::string text;
+  for(int i = 0; text.size() < 20000; i++) text += "<div class='q'>network " + std::to_string(i % 37) + "</div>\n";
+  roundtrip(text, 1);
+  roundtrip(text, 1460);
+  roundtrip(text, text.size());
+
+  std::string noise;
+  uint32_t x = 12345;
+  for(int i = 0; i < 9000; i++){ x = x * 1103515245 + 12345; noise += (char)(x >> 16); }
+  roundtrip(noise, 333); // incompressible, spans several windows
+  roundtrip(noise + text + noise, 4096);
+}
+
+TEST(pages_gzip_match_plain){
+  WiFiManager wm;
+  wm.setHTTPCompression(true);
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("wm-test");
+  wm.resetProcessStats();
+
+  const char *pages[] = {"/", "/0wifi", "/param"};
+  uint32_t in = 0, out = 0;
+  for(const char *uri : pages){
+    wmsim::ResponseRef plain = serve(wm, uri, host);
+    wmsim::ResponseRef z     = serve(wm, uri, gzip);
+    CHECK(plain->header("Content-Encoding") == "");
+    CHECK(z->header("Content-Encoding") == "gzip");
+    CHECK(z->header("Vary") == "Accept-Encoding");
+    CHECK(z->body.size() < plain->body.size());
+
+    std::string back;
+    CHECK(gunzip(z->body, back));
+    CHECK_EQ(back.size(), plain->body.size());
+#ifdef WM_HOST_ZLIB
+    CHECK(back == plain->body);
+#endif
+    in  += plain->body.size();
+    out += z->body.size();
+  }
+
+  WiFiManager::wm_httpstats_t stats = wm.getHTTPStats();
+  CHECK_EQ(stats.gzipped, 3);
+  CHECK_EQ(stats.gzipin, in);
+  CHECK_EQ(stats.gzipout, out);
+}
+
+TEST(gzip_off_by_default){
+  WiFiManager wm;
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("wm-test");
+  wmsim::ResponseRef r = serve(wm, "/", gzip);
+  CHECK_EQ(r->code, 200);
+  CHECK(r->header("Content-Encoding") == "");
+  CHECK_EQ(wm.getHTTPStats().gzipped, 0);
+}
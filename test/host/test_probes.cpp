@@ -0,0 +1,88 @@
+/**
+ * os captive portal probes, redirected while the captive portal is up, answered as online otherwise
+ */
+#include "test.h"
+
+namespace {
+
+wmsim::ResponseRef probe(WiFiManager &wm, const String &host, const String &uri){
+  wmsim::ResponseRef r = wmsim::request("GET", uri, {}, {{"Host", host}});
+  wmtest::loopUntil(wm, 5000, [&]{ return r->ended; });
+  return r;
+}
+
+void portal(WiFiManager &wm){
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("wm-test");
+  wm.resetProcessStats();
+}
+
+} // namespace
+
+TEST(probes_redirect_while_captive){
+  WiFiManager wm;
+  portal(wm);
+
+  wmsim::ResponseRef r = probe(wm, "connectivitycheck.gstatic.com", "/generate_204");
+  CHECK_EQ(r->code, 302);
+  CHECK(r->header("Location").indexOf("192.168.4.1") >= 0);
+  r = probe(wm, "captive.apple.com", "/hotspot-detect.html");
+  CHECK_EQ(r->code, 302);
+  r = probe(wm, "www.msftconnecttest.com", "/connecttest.txt");
+  CHECK_EQ(r->code, 302);
+
+  WiFiManager::wm_httpstats_t stats = wm.getHTTPStats();
+  CHECK_EQ(stats.probes[WiFiManager::WM_PROBE_ANDROID], 1);
+  CHECK_EQ(stats.probes[WiFiManager::WM_PROBE_APPLE], 1);
+  CHECK_EQ(stats.probes[WiFiManager::WM_PROBE_WINDOWS], 1);
+  CHECK_EQ(stats.proberedirects, 3);
+}
+
+TEST(probes_online_without_captive){
+  WiFiManager wm;
+  wm.setCaptivePortalEnable(false);
+  portal(wm);
+
+  wmsim::ResponseRef r = probe(wm, "192.168.4.1", "/generate_204");
+  CHECK_EQ(r->code, 204);
+  CHECK(r->body.empty());
+  r = probe(wm, "192.168.4.1", "/hotspot-detect.html");
+  CHECK_EQ(r->code, 200);
+  CHECK(r->body.find("Success") != std::string::npos);
+  r = probe(wm, "192.168.4.1", "/ncsi.txt");
+  CHECK(r->body == "Microsoft NCSI");
+  r = probe(wm, "192.168.4.1", "/success.txt");
+  CHECK(r->body == "success\n");
+
+  WiFiManager::wm_httpstats_t stats = wm.getHTTPStats();
+  CHECK_EQ(stats.probes[WiFiManager::WM_PROBE_FIREFOX], 1);
+  CHECK_EQ(stats.proberedirects, 0);
+}
+
+TEST(probes_online_after_save){
+  wmsim::addAP("home", "secret123");
+  WiFiManager wm;
+  portal(wm);
+
+  wmsim::ResponseRef r = wmsim::request("POST", "/wifisave", {{"s", "home"}, {"p", "secret123"}}, {{"Host", "192.168.4.1"}});
+  wmtest::loopUntil(wm, 1000, [&]{ return r->ended; });
+  CHECK_EQ(r->code, 200);
+
+  // saving, the os is told it is online so it closes the captive sheet on its own
+  r = probe(wm, "192.168.4.1", "/generate_204");
+  CHECK_EQ(r->code, 204);
+  CHECK_EQ(wm.getHTTPStats().proberedirects, 0);
+}
+
+TEST(probe_paths_exact){
+  WiFiManager wm;
+  wm.setCaptivePortalEnable(false);
+  portal(wm);
+
+  CHECK_EQ(probe(wm, "192.168.4.1", "/generate_2040")->code, 404);
+  CHECK_EQ(probe(wm, "192.168.4.1", "/Generate_204")->code, 404);
+  uint32_t total = 0;
+  WiFiManager::wm_httpstats_t stats = wm.getHTTPStats();
+  for(int i = 0; i < WiFiManager::WM_PROBE_MAX; i++) total += stats.probes[i];
+  CHECK_EQ(total, 0);
+}
@@ -0,0 +1,82 @@
+/**
+ * non blocking reconnect scheduler, backoff intervals, cap, stop policy and reset on connect
+ */
+#include "test.h"
+
+namespace {
+
+void connected(WiFiManager &wm){
+  wmsim::addAP("home", "secret123");
+  wmsim::saveConfig("home", "secret123");
+  wm.setReconnectBackoff(true, 500, 8000);
+  CHECK(wm.autoConnect("wm-test"));
+}
+
+} // namespace
+
+TEST(backoff_grows_and_caps){
+  WiFiManager wm;
+  connected(wm);
+
+  wmsim::removeAP("home");
+  size_t first = wmsim::radio.begins.size();
+  unsigned long drop = wmsim::elapsedMs();
+  wmsim::dropLink();
+  wmtest::loopFor(wm, 40000);
+
+  std::vector<unsigned long> &b = wmsim::radio.begins;
+  CHECK(b.size() - first >= 5);
+  if(b.size() - first < 5) return;
+
+  // gap is failed association plus interval, +-25% jitter and one loop step
+  unsigned long assoc = wmsim::radio.assocMs;
+  CHECK_RANGE(b[first] - drop, 375, 625 + 10);                     // dropped, retry at min
+  CHECK_RANGE(b[first+1] - b[first] - assoc, 3000, 5000 + 10);     // no ap, slow policy 4x
+  for(size_t i = first + 2; i < b.size(); i++){
+    CHECK_RANGE(b[i] - b[i-1] - assoc, 6000, 10000 + 10);          // capped
+  }
+  CHECK(!WiFi.isConnected());
+
+  wmsim::addAP("home", "secret123");
+  CHECK(wmtest::loopUntil(wm, 12000, []{ return WiFi.isConnected(); }));
+
+  size_t after = b.size();
+  wmtest::loopFor(wm, 20000);
+  CHECK_EQ(b.size(), after); // connected, scheduler idle
+
+  // attempts reset on connect, next drop starts from min again
+  wmsim::dropLink();
+  drop = wmsim::elapsedMs();
+  CHECK(wmtest::loopUntil(wm, 2000, [&]{ return b.size() > after; }));
+  CHECK_RANGE(b[after] - drop, 375, 625 + 10);
+}
+
+TEST(wrong_password_stops){
+  WiFiManager wm;
+  connected(wm);
+
+  wmsim::addAP("home", "rotated99");
+  size_t first = wmsim::radio.begins.size();
+  wmsim::dropLink();
+  wmtest::loopFor(wm, 30000);
+
+  CHECK_EQ(wmsim::radio.begins.size() - first, 1); // same password fails the same way
+  CHECK(!WiFi.isConnected());
+  CHECK_EQ(wm.getNextDeadline(), ULONG_MAX);
+}
+
+TEST(deadline_tracks_backoff){
+  WiFiManager wm;
+  connected(wm);
+
+  wmsim::removeAP("home");
+  wmsim::dropLink();
+  wm.process();
+  unsigned long next = wm.getNextDeadline();
+  CHECK_RANGE(next, 375, 625);
+
+  delay(next);
+  size_t before = wmsim::radio.begins.size();
+  wm.process();
+  CHECK_EQ(wmsim::radio.begins.size(), before + 1); // due exactly at the deadline
+}
@@ -0,0 +1,87 @@
+/**
+ * portal route table, dispatch by path and method, not found and mounted prefix
+ */
+#include "test.h"
+
+namespace {
+
+const wmsim::Pairs host = {{"Host", "192.168.4.1"}};
+
+void portal(WiFiManager &wm){
+  wm.setConfigPortalBlocking(false);
+  wm.startConfigPortal("wm-test");
+}
+
+wmsim::ResponseRef serve(WiFiManager &wm, const String &method, const String &uri){
+  wmsim::ResponseRef r = wmsim::request(method, uri, {}, host);
+  wmtest::loopUntil(wm, 5000, [&]{ return r->ended; });
+  return r;
+}
+
+} // namespace
+
+TEST(routes_dispatch){
+  WiFiManager wm;
+  portal(wm);
+
+  const char *pages[] = {"/", "/0wifi", "/info", "/param", "/status"};
+  for(const char *uri : pages){
+    wmsim::ResponseRef r = serve(wm, "GET", uri);
+    CHECK_EQ(r->code, 200);
+    if(r->code != 200) fprintf(stderr, "  GET %s\n", uri);
+  }
+  CHECK_EQ(serve(wm, "HEAD", "/info")->code, 200);
+  CHECK_EQ(wm.getHTTPStats().requests, 6);
+}
+
+TEST(routes_method){
+  WiFiManager wm;
+  portal(wm);
+
+  wmsim::ResponseRef r = serve(wm, "POST", "/info");
+  CHECK_EQ(r->code, 405);
+  CHECK(r->header("Allow") == "GET, HEAD");
+
+  r = serve(wm, "DELETE", "/wifisave");
+  CHECK_EQ(r->code, 405);
+  CHECK(r->header("Allow") == "GET, HEAD, POST");
+
+  CHECK_EQ(serve(wm, "POST", "/param")->code, 405);
+  CHECK_EQ(serve(wm, "POST", "/paramsave")->code, 200);
+}
+
+TEST(routes_not_found){
+  WiFiManager wm;
+  portal(wm);
+
+  CHECK_EQ(serve(wm, "GET", "/infox")->code, 404);
+  CHECK_EQ(serve(wm, "GET", "/inf")->code, 404);
+  CHECK_EQ(serve(wm, "GET", "/INFO")->code, 404);
+  CHECK_EQ(serve(wm, "GET", "/info/")->code, 404);
+}
+
+TEST(routes_mounted_prefix){
+  WiFiManager wm;
+  ESP8266WebServer app(80);
+  bool appNotFound = false;
+  app.onNotFound([&]{ appNotFound = true; app.send(404, "text/plain", "app"); });
+  app.begin();
+  WiFi.mode(WIFI_STA);
+  wm.startWebPortal(app, "/wm");
+
+  auto serveApp = [&](const String &uri){
+    wmsim::ResponseRef r = wmsim::request("GET", uri, {}, host);
+    for(int i = 0; i < 100 && !r->ended; i++){
+      app.handleClient();
+      wm.process();
+      delay(10);
+    }
+    return r;
+  };
+
+  CHECK_EQ(serveApp("/wm/info")->code, 200);
+  CHECK_EQ(serveApp("/wm")->code, 200); // prefix alone is the portal root
+  CHECK(!appNotFound);
+  CHECK_EQ(serveApp("/info")->code, 404);
+  CHECK(appNotFound);
+}
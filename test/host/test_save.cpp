@@ -0,0 +1,82 @@
+/**
+ * non blocking /wifisave, close delay, connect wait in process() slices and early end on a terminal status
+ */
+#include "test.h"
+
+namespace {
+
+void portal(WiFiManager &wm){
+  wm.setConfigPortalBlocking(false);
+  wm.setPortalEvents(true);
+  CHECK(!wm.autoConnect("wm-test"));
+  CHECK(wm.getConfigPortalActive());
+}
+
+wmsim::ResponseRef save(const String &ssid, const String &pass){
+  return wmsim::request("POST", "/wifisave", {{"s", ssid}, {"p", pass}}, {{"Host", "192.168.4.1"}});
+}
+
+// ms until process() reports a connect or evt is posted
+long until(WiFiManager &wm, WiFiManager::wm_event_t evt, unsigned long ms){
+  unsigned long start = wmsim::elapsedMs();
+  while(wmsim::elapsedMs() - start < ms){
+    bool done = wm.process();
+    WiFiManager::wm_event_t e;
+    while(wm.getPortalEvent(e)) if(e == evt) done = true;
+    if(done) return wmsim::elapsedMs() - start;
+    delay(10);
+  }
+  return -1;
+}
+
+} // namespace
+
+TEST(save_connects_in_slices){
+  wmsim::addAP("home", "secret123");
+  WiFiManager wm;
+  portal(wm);
+  wm.resetProcessStats();
+
+  wmsim::ResponseRef r = save("home", "secret123");
+  wm.process();
+  CHECK_EQ(r->code, 200); // page served before the connect starts
+
+  long took = until(wm, WiFiManager::WM_EVT_CONNECTED, 10000);
+  unsigned long conn = wmsim::radio.assocMs + wmsim::radio.dhcpMs;
+  CHECK_RANGE(took, 2000 + conn - 20, 2000 + conn + 50); // close delay, then associate and dhcp
+  CHECK(WiFi.isConnected());
+  CHECK(wmsim::savedSSID() == "home");
+  CHECK(wm.getProcessMaxLatency() < 5000); // nothing waited inside process()
+}
+
+TEST(wrong_password_ends_early){
+  wmsim::addAP("home", "secret123");
+  WiFiManager wm;
+  wm.setSaveConnectTimeout(30);
+  wm.setConnectRetries(3);
+  portal(wm);
+
+  save("home", "nottheone");
+  long took = until(wm, WiFiManager::WM_EVT_CONNECTFAILED, 40000);
+  CHECK_RANGE(took, 2000 + wmsim::radio.assocMs - 20, 2000 + wmsim::radio.assocMs + 50); // no retries, no save timeout
+  CHECK_EQ(wmsim::radio.begins.size(), 1);
+  CHECK(wm.getConfigPortalActive());
+
+  save("home", "secret123");
+  CHECK(until(wm, WiFiManager::WM_EVT_CONNECTED, 10000) > 0);
+  CHECK(WiFi.isConnected());
+}
+
+TEST(missing_ap_retries_then_fails){
+  WiFiManager wm;
+  wm.setSaveConnectTimeout(30);
+  wm.setConnectRetries(2);
+  portal(wm);
+
+  save("gone", "secret123");
+  long took = until(wm, WiFiManager::WM_EVT_CONNECTFAILED, 40000);
+  CHECK(took > 0);
+  CHECK(took < 30000);
+  CHECK_EQ(wmsim::radio.begins.size(), 2);
+  CHECK(!WiFi.isConnected());
+}
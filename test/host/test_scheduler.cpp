@@ -0,0 +1,89 @@
+/**
+ * process() scheduler, budget and round robin between http, save and the background tasks
+ */
+#include "test.h"
+
+namespace {
+
+// non blocking portal, no captive close delay, /slow holds the loop for ms
+void portal(WiFiManager &wm, unsigned long slowms){
+  wm.setConfigPortalBlocking(false);
+  wm.setCaptivePortalEnable(false);
+  wm.setWebServerCallback([&wm, slowms](){
+    wm.server->on("/slow", [&wm, slowms](){
+      delay(slowms);
+      wm.server->send(200, "text/plain", "slow");
+    });
+  });
+  wm.startConfigPortal("wm-test");
+}
+
+wmsim::ResponseRef get(const String &uri){
+  return wmsim::request("GET", uri, {}, {{"Host", "192.168.4.1"}});
+}
+
+} // namespace
+
+TEST(budget_ends_http_slice){
+  WiFiManager wm;
+  wm.setProcessBudget(10);
+  portal(wm, 30);
+  wm.resetProcessStats();
+
+  for(int i = 0; i < 6; i++) get("/slow");
+  wm.process();
+  CHECK_EQ(wmsim::pending(), 5);                       // one slow request spends the budget
+  CHECK_RANGE(wm.getProcessMaxLatency(), 30000, 32000); // a handler is never preempted
+  CHECK_RANGE(wm.getTaskMaxTime(WiFiManager::WM_TASK_HTTP), 30000, 32000);
+}
+
+TEST(save_not_starved_by_http){
+  wmsim::addAP("home", "secret123");
+  WiFiManager wm;
+  wm.setProcessBudget(10);
+  portal(wm, 30);
+
+  wmsim::request("POST", "/wifisave", {{"s", "home"}, {"p", "secret123"}}, {{"Host", "192.168.4.1"}});
+  for(int i = 0; i < 5; i++) get("/slow");
+
+  // a pass that ran out of budget in http resumes at the save task ahead of the backlog
+  int passes = 0;
+  while(wmsim::radio.begins.empty() && passes < 10){
+    wm.process();
+    passes++;
+  }
+  CHECK(passes <= 2);
+  CHECK(wmsim::pending() >= 3);
+
+  bool connected = wmtest::loopUntil(wm, 5000, [&]{ return WiFi.isConnected(); });
+  CHECK(connected);
+}
+
+TEST(dns_every_pass){
+  WiFiManager wm;
+  wm.setProcessBudget(10);
+  portal(wm, 30);
+
+  uint32_t polls = wmsim::dnsPolls;
+  for(int i = 0; i < 4; i++) get("/slow");
+  for(int i = 0; i < 4; i++) wm.process();
+  CHECK_EQ(wmsim::dnsPolls - polls, 4); // never skipped for budget
+  CHECK_EQ(wmsim::pending(), 0);
+}
+
+TEST(pump_drains_backlog){
+  WiFiManager wm;
+  portal(wm, 5);
+  wm.resetProcessStats();
+
+  for(int i = 0; i < 6; i++) get("/slow");
+  wm.process();
+  CHECK_EQ(wmsim::pending(), 2); // no budget, one pump slice of 4
+  CHECK_EQ(wm.getHTTPStats().requests, 4);
+  CHECK_EQ(wm.getHTTPStats().depthmax, 5);
+
+  wm.setHTTPPump(1);
+  wm.process();
+  CHECK_EQ(wmsim::pending(), 1); // one handleClient per slice
+  CHECK_EQ(wm.getHTTPStats().requests, 5);
+}
@@ -0,0 +1,49 @@
+/**
+ * deadline timers across millis() rollover, portal timeout and getNextDeadline
+ */
+#include "test.h"
+
+TEST(portal_timeout_across_rollover){
+  wmsim::reset(ULONG_MAX - 5000);
+  WiFiManager wm;
+  wm.setConfigPortalBlocking(false);
+  wm.setConfigPortalTimeout(20);
+  unsigned long start = wmsim::elapsedMs();
+  CHECK(!wm.autoConnect("wm-test"));
+
+  CHECK(!wmtest::loopUntil(wm, 19900, [&]{ return !wm.getConfigPortalActive(); }));
+  CHECK(millis() < 20000); // rolled over while the portal was up
+  CHECK(wmtest::loopUntil(wm, 1000, [&]{ return !wm.getConfigPortalActive(); }));
+  CHECK_RANGE(wmsim::elapsedMs() - start, 20000, 20000 + 20);
+}
+
+TEST(blocking_portal_timeout_across_rollover){
+  wmsim::reset(ULONG_MAX - 3000);
+  WiFiManager wm;
+  wm.setConfigPortalTimeout(10);
+  unsigned long start = wmsim::elapsedMs();
+  CHECK(!wm.startConfigPortal("wm-test"));
+  CHECK_RANGE(wmsim::elapsedMs() - start, 10000, 10000 + 200);
+  CHECK(!wm.getConfigPortalActive());
+}
+
+TEST(next_deadline_across_rollover){
+  wmsim::reset(ULONG_MAX - 1000);
+  WiFiManager wm;
+  wm.setConfigPortalBlocking(false);
+  wm.setConfigPortalTimeout(5);
+  CHECK(!wm.autoConnect("wm-test"));
+
+  // preload scan cache and portal timeout are armed, the portal is the later one
+  unsigned long next = wm.getNextDeadline();
+  CHECK(next <= 5000);
+  delay(3000); // past rollover
+  wm.process();
+  next = wm.getNextDeadline();
+  CHECK(next <= 2000);
+  CHECK(next > 0);
+
+  wmtest::loopUntil(wm, 2100, [&]{ return !wm.getConfigPortalActive(); });
+  CHECK(!wm.getConfigPortalActive());
+  CHECK_EQ(wm.getNextDeadline(), ULONG_MAX);
+}
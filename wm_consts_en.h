@@ -34,20 +34,30 @@ const char * const _menutokens[_nummenutokens] PROGMEM = {
     "custom"
 };
 
-const char R_root[]               PROGMEM = "/";
-const char R_wifi[]               PROGMEM = "/wifi";
-const char R_wifinoscan[]         PROGMEM = "/0wifi";
-const char R_wifisave[]           PROGMEM = "/wifisave";
-const char R_info[]               PROGMEM = "/info";
-const char R_param[]              PROGMEM = "/param";
-const char R_paramsave[]          PROGMEM = "/paramsave";
-const char R_restart[]            PROGMEM = "/restart";
-const char R_exit[]               PROGMEM = "/exit";
-const char R_close[]              PROGMEM = "/close";
-const char R_erase[]              PROGMEM = "/erase";
-const char R_status[]             PROGMEM = "/status";
-const char R_update[]             PROGMEM = "/update";
-const char R_updatedone[]         PROGMEM = "/u";
+// routes are constexpr so the route table can hash them at compile time
+constexpr char R_root[]               PROGMEM = "/";
+constexpr char R_wifi[]               PROGMEM = "/wifi";
+constexpr char R_wifinoscan[]         PROGMEM = "/0wifi";
+constexpr char R_wifisave[]           PROGMEM = "/wifisave";
+constexpr char R_info[]               PROGMEM = "/info";
+constexpr char R_param[]              PROGMEM = "/param";
+constexpr char R_paramsave[]          PROGMEM = "/paramsave";
+constexpr char R_restart[]            PROGMEM = "/restart";
+constexpr char R_exit[]               PROGMEM = "/exit";
+constexpr char R_close[]              PROGMEM = "/close";
+constexpr char R_erase[]              PROGMEM = "/erase";
+constexpr char R_status[]             PROGMEM = "/status";
+constexpr char R_update[]             PROGMEM = "/update";
+constexpr char R_updatedone[]         PROGMEM = "/u";
+
+// os captive portal probes, answered by the probe table, see handleProbe
+constexpr char R_probeandroid[]       PROGMEM = "/generate_204";
+constexpr char R_probeandroid2[]      PROGMEM = "/gen_204";
+constexpr char R_probeapple[]         PROGMEM = "/hotspot-detect.html";
+constexpr char R_probeapple2[]        PROGMEM = "/library/test/success.html";
+constexpr char R_probewindows[]       PROGMEM = "/connecttest.txt";
+constexpr char R_probewindows2[]      PROGMEM = "/ncsi.txt";
+constexpr char R_probefirefox[]       PROGMEM = "/success.txt";
 
 
 //Strings
@@ -86,6 +96,20 @@ const char HTTP_HEAD_CT[]         PROGMEM = "text/html";
 const char HTTP_HEAD_CT2[]        PROGMEM = "text/plain";
 const char HTTP_HEAD_CORS[]       PROGMEM = "Access-Control-Allow-Origin";
 const char HTTP_HEAD_CORS_ALLOW_ALL[]  PROGMEM = "*";
+const char HTTP_HEAD_ACCEPTENC[]  PROGMEM = "Accept-Encoding";
+const char HTTP_HEAD_CONTENTENC[] PROGMEM = "Content-Encoding";
+const char HTTP_HEAD_VARY[]       PROGMEM = "Vary";
+const char HTTP_HEAD_GZIP[]       PROGMEM = "gzip";
+
+// prebuilt probe responses once the portal is done, what each os expects from the internet
+const char HTTP_PROBE_204[]       PROGMEM = "HTTP/1.1 204 No Content\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
+const char HTTP_PROBE_APPLE[]     PROGMEM = "HTTP/1.1 200 OK\r\nContent-Type: text/html\r\nContent-Length: 68\r\nConnection: close\r\n\r\n<HTML><HEAD><TITLE>Success</TITLE></HEAD><BODY>Success</BODY></HTML>";
+const char HTTP_PROBE_WINDOWS[]   PROGMEM = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 22\r\nConnection: close\r\n\r\nMicrosoft Connect Test";
+const char HTTP_PROBE_NCSI[]      PROGMEM = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 14\r\nConnection: close\r\n\r\nMicrosoft NCSI";
+const char HTTP_PROBE_FIREFOX[]   PROGMEM = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: 8\r\nConnection: close\r\n\r\nsuccess\n";
+
+// captive portal redirect, %s is the portal host, ip and port if not 80, see buildCaptiveRedirect
+const char HTTP_CP_REDIRECT[]     PROGMEM = "HTTP/1.1 302 Found\r\nLocation: http://%s\r\nContent-Type: text/plain\r\nContent-Length: 0\r\nConnection: close\r\n\r\n";
 
 const char * const WIFI_STA_STATUS[] PROGMEM
 {
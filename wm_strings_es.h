@@ -82,6 +82,8 @@ const char HTTP_FORM_PARAM[]       PROGMEM = "<br/><input id='{i}' name='{n}' ma
 const char HTTP_SCAN_LINK[]        PROGMEM = "<br/><form action='/wifi?refresh=1' method='POST'><button name='refresh' value='1'>Refresh</button></form>";
 const char HTTP_SAVED[]            PROGMEM = "<div class='msg'>Saving Credentials<br/>Trying to connect ESP to network.<br />If it fails reconnect to AP to try again</div>";
 const char HTTP_PARAMSAVED[]       PROGMEM = "<div class='msg S'>Saved<br/></div>";
+const char HTTP_SAVEREJECT[]       PROGMEM = "<div class='msg D'><strong>No guardado</strong><br/>{r}</div>"; // {r=reason}
+const char HTTP_SAVEWARN[]         PROGMEM = "<div class='msg'>{r}</div>";
 const char HTTP_END[]              PROGMEM = "</div></body></html>";
 const char HTTP_ERASEBTN[]         PROGMEM = "<br/><form action='/erase' method='get'><button class='D'>Erase WiFi Config</button></form>";
 const char HTTP_UPDATEBTN[]        PROGMEM = "<br/><form action='/update' method='get'><button>Actualizer</button></form>";
@@ -93,6 +95,7 @@ const char HTTP_STATUS_OFFPW[]     PROGMEM = "<br/>Authentication Failure"; // S
 const char HTTP_STATUS_OFFNOAP[]   PROGMEM = "<br/>No Encontrado";   // WL_NO_SSID_AVAIL
 const char HTTP_STATUS_OFFFAIL[]   PROGMEM = "<br/>No se pudo conectar"; // WL_CONNECT_FAILED
 const char HTTP_STATUS_NONE[]      PROGMEM = "<div class='msg'>Sin AP establecido</div>";
+const char HTTP_STATUS_CONN[]      PROGMEM = "<div class='msg'><strong>Conectando</strong> a {v}</div>";
 const char HTTP_BR[]               PROGMEM = "<br/>";
 
 const char HTTP_STYLE[]            PROGMEM = "<style>"
@@ -220,6 +223,8 @@ const char HTTP_INFO_dnss[]       PROGMEM = "<dt>DNS Server</dt><dd>{1}</dd>";
 const char HTTP_INFO_host[]       PROGMEM = "<dt>Hostname</dt><dd>{1}</dd>";
 const char HTTP_INFO_stamac[]     PROGMEM = "<dt>Station MAC</dt><dd>{1}</dd>";
 const char HTTP_INFO_conx[]       PROGMEM = "<dt>Connected</dt><dd>{1}</dd>";
+const char HTTP_INFO_conxtime[]   PROGMEM = "<dt>Connect Time</dt><dd>link {1}ms, ip {2}ms, total {3}ms<br/>{r}</dd>";
+const char HTTP_INFO_conxstats[]  PROGMEM = "<dt>Connect Stats</dt><dd>{1} ok, {2} failed<br/>{r}</dd>"; // {r=reason:count}
 const char HTTP_INFO_autoconx[]   PROGMEM = "<dt>Autoconnect</dt><dd>{1}</dd>";
 
 const char HTTP_INFO_aboutver[]     PROGMEM = "<dt>WiFiManager</dt><dd>{1}</dd>";
@@ -237,6 +242,10 @@ const char S_GET[]                PROGMEM = "GET";
 const char S_POST[]               PROGMEM = "POST";
 const char S_NA[]                 PROGMEM = "Unknown";
 const char S_passph[]             PROGMEM = "********";
+const char S_savenopass[]         PROGMEM = "{v} requiere una contraseña";
+const char S_savebadpass[]        PROGMEM = "La longitud de la contraseña no es válida para {v}";
+const char S_savenotfound[]       PROGMEM = "{v} no se encontró en el último escaneo, intentando de todos modos";
+const char S_saveopenpass[]       PROGMEM = "{v} es una red abierta, la contraseña puede impedir la conexión";
 const char S_titlewifisaved[]     PROGMEM = "Credentials Saved";
 const char S_titlewifisettings[]  PROGMEM = "Settings Saved";
 const char S_titlewifi[]          PROGMEM = "Config ESP";